@@ -1,8 +1,17 @@
 #include "core/load.h"
 
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <mutex>
+
 #include "audio/device.h"
 #include "core/io.h"
 #include "core/loc.h"
+#include "core/log.h"
+#include "core/thrp.h"
+#include "gfx/atlas.h"
 #include "gfx/image.h"
 
 using namespace arc;
@@ -14,6 +23,14 @@ std::unordered_map<location, std::any> resource_map_;
 
 std::unordered_map<location, std::any>& get_resource_map_() { return resource_map_; }
 
+// decoded tasks, shared with the workers so they can outlive the loader.
+struct loader_staged_ {
+    std::mutex mtx;
+    std::deque<std::function<void()>> decoded;
+    // decodes handed to the workers and not finalized yet.
+    int in_flight = 0;
+};
+
 void scan_loader::scan(const path& path_root) {
     for (const path& path_ : path_root.recurse_files()) {
         if (path_.judge() == path_type::file) {
@@ -25,6 +42,12 @@ void scan_loader::scan(const path& path_root) {
                 tasks.push([sttg, path_, loc]() { sttg(path_, loc); });
                 total_tcount_++;
             }
+            if (staged_strategy_map.find(fmt) != staged_strategy_map.end()) {
+                for (const staged_strategy& sttg : staged_strategy_map[fmt]) {
+                    decode_queue_.push_back([sttg, path_, loc]() { return sttg(path_, loc); });
+                    total_tcount_++;
+                }
+            }
         }
     }
 }
@@ -42,14 +65,57 @@ void scan_loader::next() {
         start_called_ = true;
     }
 
+    if (staged_ == nullptr) staged_ = std::make_shared<loader_staged_>();
+    loader_staged_& st = *staged_;
+    std::unique_lock lk(st.mtx);
+    // the workers decode in parallel, a few at a time, the pool is shared with the rest of the engine.
+    while (!decode_queue_.empty() && st.in_flight < ARC_LOADER_DECODE_PARALLEL) {
+        auto decode = std::move(decode_queue_.back());
+        decode_queue_.pop_back();
+        st.in_flight++;
+        thread_pool::execute([decode = std::move(decode), sp = staged_]() {
+            std::function<void()> fin;
+            try {
+                fin = decode();
+            } catch (...) {
+                // the pool swallows exceptions, the failure is raised on the main thread instead.
+                std::exception_ptr ep = std::current_exception();
+                fin = [ep]() { std::rethrow_exception(ep); };
+            }
+            std::lock_guard lk(sp->mtx);
+            sp->decoded.push_back(std::move(fin));
+        });
+    }
+
+    // finalize as many as the budget allows, at least one so loading always moves on.
+    auto start = std::chrono::steady_clock::now();
+    while (!st.decoded.empty()) {
+        auto fin = std::move(st.decoded.front());
+        st.decoded.pop_front();
+        lk.unlock();
+        if (fin) fin();
+        lk.lock();
+        st.in_flight--;
+        done_tcount_++;
+        double spent = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (spent > ARC_LOADER_FINALIZE_BUDGET) break;
+    }
+    int waiting = static_cast<int>(st.decoded.size());
+    bool staging = st.in_flight > 0 || !decode_queue_.empty();
+    lk.unlock();
+
     if (!tasks.empty()) {
         auto fn = tasks.top();
         tasks.pop();
         fn();
         done_tcount_++;
-        progress = static_cast<double>(done_tcount_) / static_cast<double>(total_tcount_);
+    }
+
+    if (staging || !tasks.empty()) {
+        progress = (done_tcount_ + waiting * 0.5) / static_cast<double>(total_tcount_);
     } else {
         progress = 1;
+        if (!atlas_queue_.empty()) pack_atlases_();
 
         bool can_find = false;
         for (auto& sub : subloaders) {
@@ -82,24 +148,71 @@ std::shared_ptr<scan_loader> scan_loader::make(const std::string& scope, const p
     return lptr;
 }
 
+static std::string default_atlas_group_(const location& loc) {
+    size_t cut = loc.key.find_first_of("/\\");
+    return loc.scope + ":" + (cut == std::string::npos ? "" : loc.key.substr(0, cut));
+}
+
+void scan_loader::pack_atlases_() {
+    for (auto& [group, images] : atlas_queue_) {
+        // maxrects packs tighter when the large images go in first.
+        std::sort(images.begin(), images.end(), [](const auto& a, const auto& b) {
+            long long sa = static_cast<long long>(a.second->width) * a.second->height;
+            long long sb = static_cast<long long>(b.second->width) * b.second->height;
+            if (sa != sb) return sa > sb;
+            return a.first < b.first;
+        });
+
+        // small groups get a smaller page, the smallest power of two holding them all (or the largest image).
+        long long area = 0;
+        int side = 1;
+        for (auto& [loc, img] : images) {
+            area += static_cast<long long>(img->width + ARC_ATLAS_PADDING) * (img->height + ARC_ATLAS_PADDING);
+            side = std::max({side, img->width, img->height});
+        }
+        int size = 64;
+        while (size < ARC_LOADER_ATLAS_SIZE && (size < side || static_cast<long long>(size) * size < area)) size *= 2;
+
+        std::shared_ptr<atlas_pages> pages = atlas_pages::make(size, size);
+        for (auto& [loc, img] : images) resource_map_[loc] = std::any(pages->accept(img));
+        pages->end();
+
+        // sprites of one page batch together, so the textures to switch between go down to the pages.
+        int textures = static_cast<int>(pages->pages.size()) + pages->standalone;
+        print(log_level::info, "atlas '{}': {} images in {} pages, {:.1f}% used, {} textures -> {}.", group,
+              pages->accepted, pages->pages.size(), pages->efficiency() * 100.0, pages->accepted, textures);
+    }
+    atlas_queue_.clear();
+}
+
 void scan_loader::add_equipment(loader_equip_m equipment) {
     switch (equipment) {
         case loader_equip_m::png_tex:
-            process_strategy_map[".png"] += [](const path& path_, const location& loc) {
+            staged_strategy_map[".png"].push_back([](const path& path_, const location& loc) {
                 std::shared_ptr<image> img = image::load(path_);
-                std::shared_ptr<texture> tex = texture::make(img);
-                resource_map_[loc] = std::any(tex);
-            };
+                return std::function<void()>([img, loc]() { resource_map_[loc] = std::any(texture::make(img)); });
+            });
             break;
         case loader_equip_m::png_img:
-            process_strategy_map[".png"] += [](const path& path_, const location& loc) {
+            staged_strategy_map[".png"].push_back([](const path& path_, const location& loc) {
                 std::shared_ptr<image> img = image::load(path_);
-                resource_map_[loc] = std::any(img);
-            };
+                return std::function<void()>([img, loc]() { resource_map_[loc] = std::any(img); });
+            });
+            break;
+        case loader_equip_m::png_atlas:
+            staged_strategy_map[".png"].push_back([this](const path& path_, const location& loc) {
+                std::shared_ptr<image> img = image::load(path_);
+                return std::function<void()>([this, img, loc]() {
+                    std::string group = atlas_group ? atlas_group(loc) : default_atlas_group_(loc);
+                    atlas_queue_[group].emplace_back(loc, img);
+                });
+            });
             break;
         case loader_equip_m::txt:
-            process_strategy_map[".txt"] +=
-                [](const path& path_, const location& loc) { resource_map_[loc] = std::any(io::read_str(path_)); };
+            staged_strategy_map[".txt"].push_back([](const path& path_, const location& loc) {
+                std::string str = io::read_str(path_);
+                return std::function<void()>([str = std::move(str), loc]() { resource_map_[loc] = std::any(str); });
+            });
             break;
         case loader_equip_m::wav:
             process_strategy_map[".wav"] += [](const path& path_, const location& loc) {
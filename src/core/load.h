@@ -4,10 +4,13 @@
 #include <stack>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "core/io.h"
 #include "core/loc.h"
 #include "core/multic.h"
+#include "core/thrp.h"
 
 namespace arc {
 
@@ -22,10 +25,24 @@ T fetch(const location& loc) {
     return cf ? std::any_cast<T>(it->second) : std::decay_t<T>{};
 }
 
-enum class loader_equip_m { png_tex, png_img, txt, fnt, shd, wav, lua };
+// png_atlas loads pngs as textures like png_tex, but packs them into shared atlas pages once the tasks are done.
+enum class loader_equip_m { png_tex, png_img, png_atlas, txt, fnt, shd, wav, lua };
+
+struct image;
+struct atlas_pages;
+
+#define ARC_LOADER_ATLAS_SIZE 2048
+// staged tasks decoding on the thread pool at once.
+#define ARC_LOADER_DECODE_PARALLEL ARC_THREAD_POOL_KERNELS
+// seconds of main thread finalizing (gl uploads) each #next may take.
+#define ARC_LOADER_FINALIZE_BUDGET 0.004
+
+struct loader_staged_;
 
 struct scan_loader {
     using proc_strategy = multicall<void(const path& path_, const location& loc)>;
+    // the decode stage runs on a worker, the function it returns finishes on the main thread, where gl is.
+    using staged_strategy = std::function<std::function<void()>(const path& path_, const location& loc)>;
 
     std::string scope;
     path root;
@@ -33,18 +50,27 @@ struct scan_loader {
     int done_tcount_;
     int total_tcount_;
     std::unordered_map<std::string, proc_strategy> process_strategy_map;
+    std::unordered_map<std::string, std::vector<staged_strategy>> staged_strategy_map;
     std::stack<std::function<void()>> tasks;
+    // decode stages not handed to a worker yet.
+    std::vector<std::function<std::function<void()>()>> decode_queue_;
+    std::shared_ptr<loader_staged_> staged_;
     std::vector<std::shared_ptr<scan_loader>> subloaders;
     multicall<void()> event_on_start;
     multicall<void()> event_on_end;
     bool start_called_;
     bool end_called_;
+    // which atlas a png_atlas image goes to. by default, one atlas per top folder of the scope.
+    std::function<std::string(const location& loc)> atlas_group;
+    // png_atlas images waiting to be packed, by group.
+    std::unordered_map<std::string, std::vector<std::pair<location, std::shared_ptr<image>>>> atlas_queue_;
 
     ~scan_loader();
 
     void scan(const path& path_root);
     void add_sub(std::shared_ptr<scan_loader> subloader);
-    // run a task in the queue.
+    // hand decodes to the workers, finalize decoded tasks within ARC_LOADER_FINALIZE_BUDGET and run a task in
+    // the queue. a staged task counts half when decoded and whole when finalized.
     // you may need to check the #progress to see if all tasks are done.
     void next();
     void free_node(const location& loc);
@@ -52,6 +78,8 @@ struct scan_loader {
 
     // add a built-in loader behavior to the loader.
     void add_equipment(loader_equip_m equipment);
+    // pack the queued png_atlas images, largest first, and register their sub-textures.
+    void pack_atlases_();
 
     static std::shared_ptr<scan_loader> make(const std::string& scope, const path& root);
 };
@@ -1,6 +1,7 @@
 #include "gfx/atlas.h"
 
 #include <algorithm>
+#include <climits>
 
 #include "core/log.h"
 #include "core/math.h"
@@ -8,8 +9,22 @@
 
 namespace arc {
 
+struct atlas_rect_ {
+    int x, y, w, h;
+
+    bool contains(const atlas_rect_& o) const {
+        return o.x >= x && o.y >= y && o.x + o.w <= x + w && o.y + o.h <= y + h;
+    }
+
+    bool overlaps(const atlas_rect_& o) const {
+        return o.x < x + w && o.x + o.w > x && o.y < y + h && o.y + o.h > y;
+    }
+};
+
 struct atlas::impl_ {
-    std::vector<quad> free_rects;
+    // maximal free rectangles, they may overlap each other.
+    std::vector<atlas_rect_> free_rects;
+    long long used_area = 0;
 };
 
 // for unique_ptr<impl_> to refer
@@ -21,7 +36,9 @@ atlas::~atlas() = default;
 
 void atlas::begin() {
     p_->free_rects.clear();
-    p_->free_rects.push_back(quad(0, 0, width, height));
+    // images are padded on the right and the bottom, the padding may hang over the edge.
+    p_->free_rects.push_back({0, 0, width + ARC_ATLAS_PADDING, height + ARC_ATLAS_PADDING});
+    p_->used_area = 0;
 
     output_image = image::make(width, height, pixels);
     output_texture = texture::make(nullptr);
@@ -37,63 +54,72 @@ void atlas::end() { output_texture->link_data_(output_image); }
 
 std::shared_ptr<texture> atlas::accept(std::shared_ptr<image> image) {
     if (!image || !image->pixels) return nullptr;
-    int rw = image->width;
-    int rh = image->height;
-
-    std::vector<quad>& free_rects = p_->free_rects;
-
-    int best = -1, best_score = INT_MAX;
-    for (size_t i = 0; i < free_rects.size(); ++i) {
-        const quad& fr = free_rects[i];
-        if (fr.width < rw || fr.height < rh) continue;
-        int score = std::min(fr.width - rw, fr.height - rh);
-        if (score < best_score) best_score = score, best = static_cast<int>(i);
-    }
-    if (best == -1) print_throw(log_level::fatal, "atlas is not big enough. please expand it.");
-
-    quad used = free_rects[best];
-    int dx = used.x;
-    int dy = used.y;
-
-    imgcpy(image, dx, dy);
+    std::shared_ptr<texture> tex = try_accept(image);
+    if (tex == nullptr) print_throw(log_level::fatal, "atlas is not big enough. please expand it.");
+    return tex;
+}
 
-    quad right = quad(used.x + rw + ARC_ATLAS_PADDING, used.y, used.width - rw, rh);
-    quad top = quad(used.x, used.y + rh + ARC_ATLAS_PADDING, used.width, used.height - rh);
+// cut #used out of #free, the remains are kept as up to 4 maximal rectangles.
+static void split_free_(std::vector<atlas_rect_>& out, const atlas_rect_& free, const atlas_rect_& used) {
+    if (used.x > free.x) out.push_back({free.x, free.y, used.x - free.x, free.h});
+    if (used.x + used.w < free.x + free.w)
+        out.push_back({used.x + used.w, free.y, free.x + free.w - used.x - used.w, free.h});
+    if (used.y > free.y) out.push_back({free.x, free.y, free.w, used.y - free.y});
+    if (used.y + used.h < free.y + free.h)
+        out.push_back({free.x, used.y + used.h, free.w, free.y + free.h - used.y - used.h});
+}
 
-    free_rects.erase(free_rects.begin() + best);
+std::shared_ptr<texture> atlas::try_accept(std::shared_ptr<image> image) {
+    if (!image || !image->pixels) return nullptr;
+    int rw = image->width + ARC_ATLAS_PADDING;
+    int rh = image->height + ARC_ATLAS_PADDING;
 
-    if (right.width > 0 && right.height > 0) free_rects.push_back(right);
-    if (top.width > 0 && top.height > 0) free_rects.push_back(top);
+    std::vector<atlas_rect_>& free_rects = p_->free_rects;
 
+    // best short side fit, ties go to the best long side fit.
+    int best = -1, best_short = INT_MAX, best_long = INT_MAX;
     for (size_t i = 0; i < free_rects.size(); ++i) {
-        if (free_rects[i].width == 0 || free_rects[i].height == 0) continue;
-        for (size_t j = i + 1; j < free_rects.size(); ++j) {
-            if (free_rects[j].width == 0 || free_rects[j].height == 0) continue;
-
-            quad& a = free_rects[i];
-            quad& b = free_rects[j];
-
-            if (a.x == b.x && a.width == b.width && (a.y + a.height == b.y || b.y + b.height == a.y)) {
-                if (a.y < b.y)
-                    a.height += b.height;
-                else
-                    b.height += a.height;
-                (a.y < b.y ? b : a).width = 0;
-            } else if (a.y == b.y && a.height == b.height && (a.x + a.width == b.x || b.x + b.width == a.x)) {
-                if (a.x < b.x)
-                    a.width += b.width;
-                else
-                    b.width += a.width;
-                (a.x < b.x ? b : a).height = 0;
-            }
+        const atlas_rect_& fr = free_rects[i];
+        if (fr.w < rw || fr.h < rh) continue;
+        int short_side = std::min(fr.w - rw, fr.h - rh);
+        int long_side = std::max(fr.w - rw, fr.h - rh);
+        if (short_side < best_short || (short_side == best_short && long_side < best_long)) {
+            best_short = short_side;
+            best_long = long_side;
+            best = static_cast<int>(i);
         }
     }
+    if (best == -1) return nullptr;
+
+    atlas_rect_ used = {free_rects[best].x, free_rects[best].y, rw, rh};
+    imgcpy(image, used.x, used.y);
+
+    std::vector<atlas_rect_> next;
+    next.reserve(free_rects.size() + 4);
+    for (const atlas_rect_& fr : free_rects) {
+        if (fr.overlaps(used))
+            split_free_(next, fr, used);
+        else
+            next.push_back(fr);
+    }
 
-    free_rects.erase(std::remove_if(free_rects.begin(), free_rects.end(),
-                                    [](const quad& r) { return r.width == 0 || r.height == 0; }),
-                     free_rects.end());
+    // drop rectangles inside others.
+    for (size_t i = 0; i < next.size(); ++i) {
+        if (next[i].w == 0) continue;
+        for (size_t j = 0; j < next.size(); ++j) {
+            if (i == j || next[j].w == 0) continue;
+            if (next[j].contains(next[i])) {
+                next[i].w = 0;
+                break;
+            }
+        }
+    }
+    next.erase(std::remove_if(next.begin(), next.end(), [](const atlas_rect_& r) { return r.w == 0 || r.h == 0; }),
+               next.end());
+    free_rects.swap(next);
 
-    return output_texture->cut(quad(dx, dy, image->width, image->height));
+    p_->used_area += static_cast<long long>(image->width) * image->height;
+    return output_texture->cut(quad(used.x, used.y, image->width, image->height));
 }
 
 void atlas::imgcpy(std::shared_ptr<image> image, int dest_x, int dest_y) {
@@ -108,6 +134,47 @@ void atlas::imgcpy(std::shared_ptr<image> image, int dest_x, int dest_y) {
     }
 }
 
+double atlas::efficiency() const { return static_cast<double>(p_->used_area) / (static_cast<double>(width) * height); }
+
 std::shared_ptr<atlas> atlas::make(int w, int h) { return std::make_shared<atlas>(w, h); }
 
-}  // namespace arc
\ No newline at end of file
+std::shared_ptr<texture> atlas_pages::accept(std::shared_ptr<image> image) {
+    if (!image || !image->pixels) return nullptr;
+    accepted++;
+
+    if (image->width > page_width || image->height > page_height) {
+        standalone++;
+        print(log_level::warn, "an image of {}x{} does not fit in an atlas page, it is kept alone.", image->width,
+              image->height);
+        return texture::make(image);
+    }
+
+    for (auto& page : pages) {
+        std::shared_ptr<texture> tex = page->try_accept(image);
+        if (tex != nullptr) return tex;
+    }
+
+    pages.push_back(atlas::make(page_width, page_height));
+    pages.back()->begin();
+    return pages.back()->accept(image);
+}
+
+void atlas_pages::end() {
+    for (auto& page : pages) page->end();
+}
+
+double atlas_pages::efficiency() const {
+    if (pages.empty()) return 0;
+    double sum = 0;
+    for (auto& page : pages) sum += page->efficiency();
+    return sum / pages.size();
+}
+
+std::shared_ptr<atlas_pages> atlas_pages::make(int w, int h) {
+    std::shared_ptr<atlas_pages> ap = std::make_shared<atlas_pages>();
+    ap->page_width = w;
+    ap->page_height = h;
+    return ap;
+}
+
+}  // namespace arc
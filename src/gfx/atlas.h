@@ -1,10 +1,13 @@
 #pragma once
+#include <vector>
+
 #include "gfx/image.h"
 
 #define ARC_ATLAS_PADDING 1
 
 namespace arc {
 
+// packs images into one texture with maxrects (best short side fit).
 struct atlas {
     struct impl_;
     std::unique_ptr<impl_> p_;
@@ -22,10 +25,32 @@ struct atlas {
     void end();
     // add an image to the atlas, and get its texture.
     std::shared_ptr<texture> accept(std::shared_ptr<image> image);
+    // same as #accept, but returns nullptr when the atlas is full.
+    std::shared_ptr<texture> try_accept(std::shared_ptr<image> image);
     // write an image to the atlas.
     void imgcpy(std::shared_ptr<image> image, int dest_x, int dest_y);
+    // the share of the atlas covered by accepted images.
+    double efficiency() const;
 
     static std::shared_ptr<atlas> make(int w, int h);
 };
 
-}  // namespace arc
\ No newline at end of file
+// atlases of one size, opened as they fill up.
+struct atlas_pages {
+    int page_width;
+    int page_height;
+    std::vector<std::shared_ptr<atlas>> pages;
+    // images accepted, including those too large for a page.
+    int accepted = 0;
+    // images too large for a page, with a texture of their own.
+    int standalone = 0;
+
+    // add an image to the first page with room. an image larger than a page gets a texture of its own.
+    std::shared_ptr<texture> accept(std::shared_ptr<image> image);
+    void end();
+    double efficiency() const;
+
+    static std::shared_ptr<atlas_pages> make(int w, int h);
+};
+
+}  // namespace arc
@@ -0,0 +1,115 @@
+#include "gfx/bench.h"
+
+#include <chrono>
+#include <memory>
+
+#include "core/log.h"
+#include "core/math.h"
+#include "gfx/brush.h"
+#include "gfx/buffer.h"
+#include "gfx/gl.h"
+#include "gfx/image.h"
+#include "gfx/mesh.h"
+
+namespace arc {
+
+template <typename F>
+static double quads_per_second_(complex_buffer& buf, int quads, int batch, F&& draw) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < quads; i++) {
+        draw(i);
+        // clear directly, a flush would upload.
+        if ((i + 1) % batch == 0) buf.clear();
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return secs > 0 ? quads / secs : 0;
+}
+
+brush_bench_result bench_brush_quads(int quads, int batch) {
+    brush_bench_result result;
+    auto buf = complex_buffer::make();
+    auto brush = buf->derive_brush();
+
+    // warm the buffer up to the batch size, so growth is not measured.
+    for (int i = 0; i < batch; i++) brush->draw_rect(quad(0, 0, 1, 1));
+    buf->clear();
+
+    result.rect_qps = quads_per_second_(*buf, quads, batch, [&](int i) {
+        brush->draw_rect(quad(i & 255, (i >> 8) & 255, 1, 1));
+    });
+
+    // a texture without a gl name, the brush never flushes so it is never bound.
+    auto tex = std::make_shared<texture>();
+    tex->width = tex->height = tex->full_width = tex->full_height = 16;
+    tex->is_framebuffer_ = false;
+    brush->draw_texture(tex, quad(0, 0, 1, 1));
+    buf->clear();
+
+    result.texture_qps = quads_per_second_(*buf, quads, batch, [&](int i) {
+        brush->draw_texture(tex, quad(i & 255, (i >> 8) & 255, 1, 1));
+    });
+
+    print(log_level::info, "brush bench: {} quads, rect {:.0f} quads/s, texture {:.0f} quads/s.", quads,
+          result.rect_qps, result.texture_qps);
+    return result;
+}
+
+color_bench_result bench_color_packing(int quads, int batch) {
+    color_bench_result result;
+    auto buf = complex_buffer::make();
+    auto brush = buf->derive_brush();
+
+    auto draw = [&](int i) {
+        float l = (i & 255) / 255.0f;
+        brush->vertex_color[0] = color(l, l * 0.5, 1.0 - l);
+        brush->vertex_color[1] = color(1.0 - l, l, l * 0.5);
+        brush->vertex_color[2] = color(l * 0.5, 1.0 - l, l);
+        brush->vertex_color[3] = color(l, l, l);
+        brush->draw_rect(quad(i & 255, (i >> 8) & 255, 1, 1));
+    };
+
+    const vertex_format formats[2] = {vertex_format::standard, vertex_format::ldr};
+    double* out[2] = {&result.half_qps, &result.ldr_qps};
+    for (int k = 0; k < 2; k++) {
+        brush->state_.format = formats[k];
+        for (int i = 0; i < batch; i++) draw(i);
+        buf->clear();
+        *out[k] = quads_per_second_(*buf, quads, batch, draw);
+    }
+    brush->cl_norm();
+
+    print(log_level::info, "color bench: {} quads, half {:.0f} quads/s, unorm8 {:.0f} quads/s.", quads,
+          result.half_qps, result.ldr_qps);
+    return result;
+}
+
+render_bench_result bench_render_frames(const std::function<void(brush* brush, int frame)>& scene, int frames) {
+    render_bench_result result;
+    auto direct = mesh::make();
+    direct->is_direct_ = true;
+    brush* brush = direct->brush_.get();
+
+    gl_record before = gl_recorded;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++) {
+        scene(brush, i);
+        brush->flush();
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double n = frames > 0 ? frames : 1;
+    result.frames = frames;
+    result.cpu_ms = secs * 1000.0 / n;
+    result.draw_calls = (gl_recorded.draw_calls - before.draw_calls) / n;
+    result.vertices = (gl_recorded.vertices - before.vertices) / n;
+    result.bytes_uploaded = (gl_recorded.bytes_uploaded - before.bytes_uploaded) / n;
+    result.state_changes = (gl_recorded.state_changes - before.state_changes) / n;
+
+    print(log_level::info,
+          "render bench: {} frames, {:.3f} ms/frame, {:.1f} draws, {:.0f} vertices, {:.0f} bytes up, {:.1f} state "
+          "changes per frame.",
+          frames, result.cpu_ms, result.draw_calls, result.vertices, result.bytes_uploaded, result.state_changes);
+    return result;
+}
+
+}  // namespace arc
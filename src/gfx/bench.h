@@ -0,0 +1,42 @@
+#pragma once
+#include <functional>
+
+namespace arc {
+
+struct brush_bench_result {
+    double rect_qps = 0;
+    double texture_qps = 0;
+};
+
+// how many quads per second the brush writes through #draw_rect and #draw_texture.
+// the quads go to a detached buffer that is cleared every #batch quads, nothing is uploaded or drawn,
+// so this measures the cpu side of the brush alone. a gl context is needed for the brush programs.
+brush_bench_result bench_brush_quads(int quads = 1 << 20, int batch = 4096);
+
+struct color_bench_result {
+    double half_qps = 0;
+    double ldr_qps = 0;
+};
+
+// the same for rects with four different corner colours, as the light map is built, once with half float colours and
+// once with unorm8 colours.
+color_bench_result bench_color_packing(int quads = 1 << 20, int batch = 4096);
+
+struct brush;
+
+// per frame averages of #bench_render_frames.
+struct render_bench_result {
+    int frames = 0;
+    double cpu_ms = 0;
+    double draw_calls = 0;
+    double vertices = 0;
+    double bytes_uploaded = 0;
+    double state_changes = 0;
+};
+
+// draw #frames frames of a scripted scene on a direct brush, flushed as the device loop does, and time the cpu side.
+// the scene gets its own frame counter, the render clock is not advanced.
+// the gl counts come from the null backend (ARC_NULL_GL), with a real backend they stay zero.
+render_bench_result bench_render_frames(const std::function<void(brush* brush, int frame)>& scene, int frames = 240);
+
+}  // namespace arc
@@ -1,39 +1,140 @@
 #include "gfx/brush.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
 #include "core/def.h"
 #include "core/log.h"
 #include "core/math.h"
 #include "gfx/buffer.h"
 #include "gfx/device.h"
+#include "gfx/gl.h"
 #include "gfx/image.h"
 #include "gfx/mesh.h"
 #include "gfx/shader.h"
-
-// clang-format off
-#include <gl/glew.h>
-#include <gl/gl.h>
-// clang-format on
+#include "gfx/stream.h"
 
 namespace arc {
 
-static uint16_t to_half_(float f) {
-    union {
-        float f;
-        uint32_t u;
-    } v = {f};
-    uint32_t s = (v.u >> 31) & 0x1;
-    uint32_t e = (v.u >> 23) & 0xFF;
-    uint32_t m = v.u & 0x7FFFFF;
-    if (e == 0xFF) return uint16_t((s << 15) | 0x7C00 | (m ? 1 : 0));
-    if (!e) return uint16_t((s << 15) | (m >> 13));
-    int32_t E = int32_t(e) - 127 + 15;
-    if (E > 31) E = 31;
-    if (E < 0) E = 0;
-    return uint16_t((s << 15) | (E << 10) | (m >> 13));
+static inline int16_t pack_pos_(float v, double origin) {
+    float f = std::round((v - origin) * ARC_COMPACT_POS_SCALE);
+    return static_cast<int16_t>(std::clamp(f, -32768.0f, 32767.0f));
+}
+
+static inline uint16_t pack_uv_(float v) {
+    return static_cast<uint16_t>(std::clamp(v * ARC_COMPACT_UV_SCALE + 0.5f, 0.0f, 65535.0f));
+}
+
+// write #n textured vertices in the layout of the state's format. #cols are in vertex order.
+static void put_textured_(complex_buffer* buf, const graph_state& st, int n, const color* cols, const float* xs,
+                          const float* ys, const float* us, const float* vs) {
+    switch (st.format) {
+        case vertex_format::compact: {
+            uint8_t c[16];
+            pack_unorm4(cols, n, c);
+            vertex_compact* out = buf->push_vertices<vertex_compact>(n);
+            for (int i = 0; i < n; i++) {
+                out[i].x = pack_pos_(xs[i], st.origin.x);
+                out[i].y = pack_pos_(ys[i], st.origin.y);
+                std::memcpy(out[i].col, c + i * 4, 4);
+                out[i].u = pack_uv_(us[i]);
+                out[i].v = pack_uv_(vs[i]);
+            }
+            break;
+        }
+        case vertex_format::ldr: {
+            uint8_t c[16];
+            pack_unorm4(cols, n, c);
+            vertex_textured_ldr* out = buf->push_vertices<vertex_textured_ldr>(n);
+            for (int i = 0; i < n; i++) {
+                out[i].x = xs[i];
+                out[i].y = ys[i];
+                std::memcpy(out[i].col, c + i * 4, 4);
+                out[i].u = us[i];
+                out[i].v = vs[i];
+            }
+            break;
+        }
+        default: {
+            uint16_t c[16];
+            pack_half4(cols, n, c);
+            vertex_textured* out = buf->push_vertices<vertex_textured>(n);
+            for (int i = 0; i < n; i++) {
+                out[i].x = xs[i];
+                out[i].y = ys[i];
+                std::memcpy(out[i].col, c + i * 4, 8);
+                out[i].u = us[i];
+                out[i].v = vs[i];
+            }
+            break;
+        }
+    }
 }
 
-void w_half_(complex_buffer* buf, const color& col) {
-    buf->vtx(to_half_(col.r)).vtx(to_half_(col.g)).vtx(to_half_(col.b)).vtx(to_half_(col.a));
+// write #n colored vertices in the layout of the state's format. #cols are in vertex order.
+static void put_colored_(complex_buffer* buf, const graph_state& st, int n, const color* cols, const float* xs,
+                         const float* ys) {
+    if (st.format == vertex_format::ldr) {
+        uint8_t c[16];
+        pack_unorm4(cols, n, c);
+        vertex_colored_ldr* out = buf->push_vertices<vertex_colored_ldr>(n);
+        for (int i = 0; i < n; i++) {
+            out[i].x = xs[i];
+            out[i].y = ys[i];
+            std::memcpy(out[i].col, c + i * 4, 4);
+        }
+        return;
+    }
+
+    uint16_t c[16];
+    pack_half4(cols, n, c);
+    vertex_colored* out = buf->push_vertices<vertex_colored>(n);
+    for (int i = 0; i < n; i++) {
+        out[i].x = xs[i];
+        out[i].y = ys[i];
+        std::memcpy(out[i].col, c + i * 4, 8);
+    }
+}
+
+// quads are always indexed 0 1 3 1 2 3, so every buffer shares one immutable index buffer.
+// longer buffers are drawn in batches of ARC_QUAD_INDEX_BATCH quads with a base vertex.
+static unsigned int quad_ebo_ = 0;
+
+static unsigned int quad_indices_() {
+    if (quad_ebo_ != 0) return quad_ebo_;
+
+    std::vector<uint16_t> indices(ARC_QUAD_INDEX_BATCH * 6);
+    for (int i = 0; i < ARC_QUAD_INDEX_BATCH; i++) {
+        uint16_t k = i * 4;
+        uint16_t* q = indices.data() + i * 6;
+        q[0] = k + 0;
+        q[1] = k + 1;
+        q[2] = k + 3;
+        q[3] = k + 1;
+        q[4] = k + 2;
+        q[5] = k + 3;
+    }
+
+    glGenBuffers(1, &quad_ebo_);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quad_ebo_);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+    return quad_ebo_;
+}
+
+static void draw_quads_(int quads, int base) {
+    for (int first = 0; first < quads; first += ARC_QUAD_INDEX_BATCH) {
+        int n = std::min(quads - first, ARC_QUAD_INDEX_BATCH);
+        glDrawElementsBaseVertex(GL_TRIANGLES, n * 6, GL_UNSIGNED_SHORT, 0, base + first * 4);
+    }
+}
+
+static void apply_blend_(blend_mode mode) {
+    if (mode == blend_mode::normal)
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    else if (mode == blend_mode::add)
+        glBlendFunc(GL_SRC_ALPHA, GL_SRC_ALPHA);
 }
 
 brush::brush() {
@@ -41,6 +142,9 @@ brush::brush() {
     ts_push();
     default_colored_ = program::make(builtin_program_type::colored);
     default_textured_ = program::make(builtin_program_type::textured);
+    default_compact_ = program::make(builtin_program_type::textured_compact);
+    default_textured_ldr_ = program::make(builtin_program_type::textured_ldr);
+    default_colored_ldr_ = program::make(builtin_program_type::colored_ldr);
 }
 
 graph_state& brush::current_state() { return state_; }
@@ -64,58 +168,42 @@ void brush::cl_mrg(double v) {
 }
 
 void brush::ts_push() {
-#ifndef ARC_BRUSH_CPU_TRANSFORM
-    flush();
-#endif
+    if (!cpu_transform_) flush();
     tstack_.push(transform());
 }
 
 void brush::ts_pop() {
-#ifndef ARC_BRUSH_CPU_TRANSFORM
-    flush();
-#endif
+    if (!cpu_transform_) flush();
     tstack_.pop();
 }
 
 void brush::ts_load(const transform& t) {
-#ifndef ARC_BRUSH_CPU_TRANSFORM
-    flush();
-#endif
+    if (!cpu_transform_) flush();
     tstack_.push(t);
 }
 
 void brush::ts_trs(const vec2& v) {
-#ifndef ARC_BRUSH_CPU_TRANSFORM
-    flush();
-#endif
+    if (!cpu_transform_) flush();
     tstack_.top().translate(v.x, v.y);
 }
 
 void brush::ts_scl(const vec2& v) {
-#ifndef ARC_BRUSH_CPU_TRANSFORM
-    flush();
-#endif
+    if (!cpu_transform_) flush();
     tstack_.top().scale(v.x, v.y);
 }
 
 void brush::ts_shr(const vec2& v) {
-#ifndef ARC_BRUSH_CPU_TRANSFORM
-    flush();
-#endif
+    if (!cpu_transform_) flush();
     tstack_.top().shear(v.x, v.y);
 }
 
 void brush::ts_rot(double r) {
-#ifndef ARC_BRUSH_CPU_TRANSFORM
-    flush();
-#endif
+    if (!cpu_transform_) flush();
     tstack_.top().rotate(r);
 }
 
 void brush::ts_rot(const vec2& v, double r) {
-#ifndef ARC_BRUSH_CPU_TRANSFORM
-    flush();
-#endif
+    if (!cpu_transform_) flush();
     transform& trs = tstack_.top();
     trs.translate(v.x, v.y);
     trs.rotate(r);
@@ -130,25 +218,51 @@ void brush::use_camera(const camera& cam) {
 
 void brush::use_program(std::shared_ptr<program> program) {
     if (state_.prog != program) {
-        flush();
+        if (cq_depth_ == 0) flush();
         state_.prog = program;
     }
 }
 
 void brush::use_state(const graph_state& sts) {
-    flush();
+    if (cq_depth_ == 0) flush();
     use_program(state_.prog);
     assert_texture(state_.texture);
     assert_mode(state_.mode);
     state_ = sts;
 };
 
+void brush::apply_(float& x, float& y) const {
+    if (cpu_transform_) tstack_.top().apply(x, y);
+}
+
+void brush::quad_corners_(float x1, float y1, float x2, float y2, float* xs, float* ys) const {
+    xs[0] = x2, ys[0] = y2;
+    xs[1] = x2, ys[1] = y1;
+    xs[2] = x1, ys[2] = y1;
+    xs[3] = x1, ys[3] = y2;
+    if (!cpu_transform_) return;
+
+    const transform& t = tstack_.top();
+    if (t.m00 == 1.0f && t.m01 == 0.0f && t.m10 == 0.0f && t.m11 == 1.0f) {
+        // translation only, the common case for sprites and gui.
+        for (int i = 0; i < 4; i++) xs[i] += t.m02, ys[i] += t.m12;
+        return;
+    }
+    // a rotated or sheared rectangle is no longer axis aligned, all corners go through the matrix.
+    for (int i = 0; i < 4; i++) {
+        float x = xs[i], y = ys[i];
+        xs[i] = t.m00 * x + t.m01 * y + t.m02;
+        ys[i] = t.m10 * x + t.m11 * y + t.m12;
+    }
+}
+
 transform brush::get_combined_transform() {
     transform cpy = camera_.combined_out_t;
     return cpy.mul(tstack_.top());
 }
 
 void brush::flush() {
+    if (cq_depth_ > 0) cq_drain_();
     if (wbuf == nullptr) return;
 
     auto buf = wbuf;
@@ -162,69 +276,86 @@ void brush::flush() {
                     "it seems that somewhere the brush is flushed in a mesh. the "
                     "state cannot be consistent!");
 
+    bool compact = state_.mode == graph_mode::textured_quad && state_.format == vertex_format::compact;
+    bool ldr = state_.format == vertex_format::ldr;
     std::shared_ptr<program> program_used;
     if (state_.prog != nullptr && state_.prog->program_id_ != 0)
         program_used = state_.prog;
     else
         switch (state_.mode) {
             case graph_mode::textured_quad:
-                program_used = default_textured_;
+                program_used = compact ? default_compact_ : ldr ? default_textured_ldr_ : default_textured_;
                 break;
             default:
-                program_used = default_colored_;
+                program_used = ldr ? default_colored_ldr_ : default_colored_;
                 break;
         }
 
     glBindVertexArray(msh->vao_);
-    glBindBuffer(GL_ARRAY_BUFFER, msh->vbo_);
-    if (buf->dirty) {
-        if (buf->vcap_changed_)
-            glBufferData(GL_ARRAY_BUFFER, buf->vertex_buf.capacity(), buf->vertex_buf.data(), GL_DYNAMIC_DRAW);
-        else
-            glBufferSubData(GL_ARRAY_BUFFER, 0, buf->vertex_buf.size(), buf->vertex_buf.data());
+    // the first vertex of the buffer in the bound vbo.
+    int base = 0;
+#ifdef ARC_BRUSH_STREAM_RING
+    bool streamed = msh->is_direct_;
+#else
+    bool streamed = false;
+#endif
+    if (streamed) {
+        // immediate vertices are rewritten every flush anyway, they go through the ring at an offset.
+        int stride = static_cast<int>(buf->vertex_buf.size()) / std::max(buf->vertex_count, 1);
+        base = stream_ring::direct().write(buf->vertex_buf.data(), buf->vertex_buf.size(), std::max(stride, 1));
+    } else {
+        glBindBuffer(GL_ARRAY_BUFFER, msh->vbo_);
+        if (buf->dirty) {
+            if (buf->vcap_changed_)
+                glBufferData(GL_ARRAY_BUFFER, buf->vertex_buf.capacity(), buf->vertex_buf.data(), GL_DYNAMIC_DRAW);
+            else {
+                // only send what changed, patched meshes touch a few cells at a time.
+                size_t lo = std::min(buf->dirty_lo_, buf->vertex_buf.size());
+                size_t hi = std::min(buf->dirty_hi_, buf->vertex_buf.size());
+                if (hi > lo) glBufferSubData(GL_ARRAY_BUFFER, lo, hi - lo, buf->vertex_buf.data() + lo);
+            }
+        }
     }
     buf->vcap_changed_ = false;
+    buf->dirty_lo_ = SIZE_MAX;
+    buf->dirty_hi_ = 0;
 
     glUseProgram(program_used->program_id_);
     if (program_used->callback_setup != nullptr) program_used->callback_setup(program_used.get());
 
     if (state_.callback_uniform != nullptr) state_.callback_uniform(program_used.get());
 
+    // vertices transformed on cpu only need the camera.
+    transform proj = cpu_transform_ ? camera_.combined_out_t : get_combined_transform();
+    // compact positions are fixed point from the origin.
+    const float cs = 1.0f / ARC_COMPACT_POS_SCALE;
+    if (compact) proj.translate(state_.origin.x, state_.origin.y).scale(cs, cs);
+
     if (program_used->cached_uniforms.size() == 0)
         print_throw(log_level::fatal, "please cache at lease a uniform u_proj.");
     else
-#ifdef ARC_BRUSH_CPU_TRANSFORM
-        program_used->cached_uniforms[0].set(camera_.combined_out_t);
-#else
-        program_used->cached_uniforms[0].set(get_combined_transform());
-#endif
+        program_used->cached_uniforms[0].set(proj);
 
-    if (state_.mode == graph_mode::textured_quad || state_.mode == graph_mode::colored_quad) {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, msh->ebo_);
-        if (buf->icap_changed_)
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, buf->index_buf.capacity() * 4, buf->index_buf.data(), GL_STATIC_DRAW);
-        else
-            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, buf->index_buf.size() * 4, buf->index_buf.data());
-    }
-    buf->icap_changed_ = false;
+    if (state_.mode == graph_mode::textured_quad || state_.mode == graph_mode::colored_quad)
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quad_indices_());
     buf->dirty = false;
 
     switch (state_.mode) {
         case graph_mode::textured_quad:
             state_.texture->bind_(1);
-            glDrawElements(GL_TRIANGLES, buf->index_count, GL_UNSIGNED_INT, 0);
+            draw_quads_(buf->vertex_count / 4, base);
             break;
         case graph_mode::colored_quad:
-            glDrawElements(GL_TRIANGLES, buf->index_count, GL_UNSIGNED_INT, 0);
+            draw_quads_(buf->vertex_count / 4, base);
             break;
         case graph_mode::colored_line:
-            glDrawArrays(GL_LINES, 0, buf->vertex_count);
+            glDrawArrays(GL_LINES, base, buf->vertex_count);
             break;
         case graph_mode::colored_point:
-            glDrawArrays(GL_POINTS, 0, buf->vertex_count);
+            glDrawArrays(GL_POINTS, base, buf->vertex_count);
             break;
         case graph_mode::colored_triangle:
-            glDrawArrays(GL_TRIANGLES, 0, buf->vertex_count);
+            glDrawArrays(GL_TRIANGLES, base, buf->vertex_count);
             break;
         default:
             print_throw(log_level::fatal, "uknown graphics mode.");
@@ -240,7 +371,7 @@ void brush::flush() {
 
 void brush::assert_mode(graph_mode mode) {
     if (state_.mode != mode) {
-        flush();
+        if (cq_depth_ == 0) flush();
         state_.mode = mode;
     }
 }
@@ -252,17 +383,115 @@ static unsigned int get_tex_root_(std::shared_ptr<texture> tex) {
 
 void brush::assert_texture(std::shared_ptr<texture> tex) {
     if (get_tex_root_(state_.texture) != get_tex_root_(tex)) {
-        flush();
+        if (cq_depth_ == 0) flush();
         state_.texture = tex;
     }
 }
 
+complex_buffer* brush::target_() {
+    if (cq_depth_ == 0) return wbuf;
+
+    unsigned int prog = state_.prog == nullptr ? 0 : state_.prog->program_id_;
+    unsigned int tex = get_tex_root_(state_.texture);
+    // uniform callbacks cannot be compared, so a batch with one is never joined.
+    bool compact = state_.format == vertex_format::compact;
+    auto same = [&](const brush_batch_& b) {
+        return b.layer == cq_layer_ && b.program == prog && b.texture == tex && b.blend == blend_ &&
+               b.state.mode == state_.mode && b.state.format == state_.format &&
+               b.state.callback_uniform == nullptr && state_.callback_uniform == nullptr &&
+               (!compact || (b.state.origin.x == state_.origin.x && b.state.origin.y == state_.origin.y));
+    };
+
+    if (cq_last_ >= 0 && same(cq_batches_[cq_last_])) return cq_batches_[cq_last_].target->buffer.get();
+    for (int i = 0; i < cq_used_; i++) {
+        if (!same(cq_batches_[i])) continue;
+        cq_last_ = i;
+        return cq_batches_[i].target->buffer.get();
+    }
+
+    if (cq_used_ == static_cast<int>(cq_batches_.size())) {
+        cq_batches_.emplace_back();
+        cq_batches_.back().target = mesh::make();
+        // rewritten every drain like the direct buffer, so they stream through the ring too.
+        cq_batches_.back().target->is_direct_ = true;
+    }
+    brush_batch_& b = cq_batches_[cq_used_];
+    b.layer = cq_layer_;
+    b.program = prog;
+    b.texture = tex;
+    b.blend = blend_;
+    b.state = state_;
+    cq_last_ = cq_used_++;
+    return b.target->buffer.get();
+}
+
+static bool batch_before_(const brush_batch_& b1, const brush_batch_& b2) {
+    if (b1.layer != b2.layer) return b1.layer < b2.layer;
+    if (b1.program != b2.program) return b1.program < b2.program;
+    if (b1.texture != b2.texture) return b1.texture < b2.texture;
+    if (b1.state.mode != b2.state.mode) return b1.state.mode < b2.state.mode;
+    return b1.blend < b2.blend;
+}
+
+void brush::cq_begin() {
+    if (cq_depth_ == 0) {
+        // direct vertices written before the queue are drawn before it, with their own state.
+        flush();
+        cq_saved_state_ = state_;
+        cq_saved_blend_ = blend_;
+    }
+    cq_depth_++;
+}
+
+void brush::cq_layer(int layer) { cq_layer_ = layer; }
+
+void brush::cq_end() {
+    if (cq_depth_ == 0) return;
+    if (cq_depth_ == 1) {
+        cq_drain_();
+        // draws after the queue go on with the state from before it.
+        state_ = cq_saved_state_;
+        blend_ = cq_saved_blend_;
+        apply_blend_(blend_);
+    }
+    if (--cq_depth_ == 0) cq_layer_ = 0;
+}
+
+void brush::cq_drain_() {
+    if (cq_used_ == 0) return;
+
+    std::sort(cq_batches_.begin(), cq_batches_.begin() + cq_used_, batch_before_);
+
+    graph_state old_state = state_;
+    auto old_buf = wbuf;
+    auto old_msh = mesh_root_;
+    int depth = cq_depth_;
+    // each batch is flushed as if it were drawn right now.
+    cq_depth_ = 0;
+    for (int i = 0; i < cq_used_; i++) {
+        brush_batch_& b = cq_batches_[i];
+        if (b.target->buffer->vertex_count == 0) continue;
+        state_ = b.state;
+        apply_blend_(b.blend);
+        wbuf = b.target->buffer.get();
+        mesh_root_ = b.target.get();
+        flush();
+    }
+    apply_blend_(blend_);
+    cq_depth_ = depth;
+    mesh_root_ = old_msh;
+    wbuf = old_buf;
+    state_ = old_state;
+    cq_used_ = 0;
+    cq_last_ = -1;
+}
+
 void brush::draw_texture(std::shared_ptr<texture> tex, const quad& dst, const quad& src, uint8_t flag) {
     if (tex == nullptr) return;
-    auto buf = wbuf;
 
     assert_mode(graph_mode::textured_quad);
     assert_texture(tex);
+    auto buf = target_();
 
     float u = (src.x + tex->u) / tex->full_width;
     float v = (src.y + tex->v) / tex->full_height;
@@ -278,25 +507,14 @@ void brush::draw_texture(std::shared_ptr<texture> tex, const quad& dst, const qu
         std::swap(v, v2);
 
     float x = dst.x, y = dst.y, w = dst.width, h = dst.height;
-    float x1 = x, y1 = y, x2 = x + w, y2 = y + h;
-#ifdef ARC_BRUSH_CPU_TRANSFORM
-    auto& ts = tstack_.top();
-    ts.apply(x1, y1);
-    ts.apply(x2, y2);
-#endif
+    float xs[4], ys[4];
+    quad_corners_(x, y, x + w, y + h, xs, ys);
 
-    buf->vtx(x2).vtx(y2);
-    w_half_(buf, vertex_color[2]);
-    buf->vtx(u2).vtx(v);
-    buf->vtx(x2).vtx(y1);
-    w_half_(buf, vertex_color[3]);
-    buf->vtx(u2).vtx(v2);
-    buf->vtx(x1).vtx(y1);
-    w_half_(buf, vertex_color[0]);
-    buf->vtx(u).vtx(v2);
-    buf->vtx(x1).vtx(y2);
-    w_half_(buf, vertex_color[1]);
-    buf->vtx(u).vtx(v);
+    // quads are written from the bottom right corner, see #quad_corners_.
+    const color cols[4] = {vertex_color[2], vertex_color[3], vertex_color[0], vertex_color[1]};
+    const float us[4] = {u2, u2, u, u};
+    const float vs[4] = {v, v2, v2, v};
+    put_textured_(buf, state_, 4, cols, xs, ys, us, vs);
 
     buf->end_quad();
 }
@@ -305,27 +523,48 @@ void brush::draw_texture(std::shared_ptr<texture> tex, const quad& dst, uint8_t
     if (tex != nullptr) draw_texture(tex, dst, quad(0.0, 0.0, tex->width, tex->height), flag);
 }
 
-void brush::draw_rect(const quad& dst) {
-    auto buf = wbuf;
+void brush::draw_texture_run(const std::shared_ptr<texture>& tex, int count, const quad* dst, const quad* src,
+                             const color* cols) {
+    if (tex == nullptr || count <= 0) return;
 
+    assert_mode(graph_mode::textured_quad);
+    assert_texture(tex);
+    auto buf = target_();
+
+#ifdef ARC_Y_IS_DOWN
+    bool flip = !tex->is_framebuffer_;
+#else
+    bool flip = tex->is_framebuffer_;
+#endif
+    float fw = tex->full_width, fh = tex->full_height;
+
+    for (int i = 0; i < count; i++) {
+        float u = src[i].x / fw, u2 = src[i].prom_x() / fw;
+        float v = src[i].y / fh, v2 = src[i].prom_y() / fh;
+        if (flip) std::swap(v, v2);
+
+        float x = dst[i].x, y = dst[i].y;
+        float xs[4], ys[4];
+        quad_corners_(x, y, x + static_cast<float>(dst[i].width), y + static_cast<float>(dst[i].height), xs, ys);
+
+        const color c4[4] = {cols[i], cols[i], cols[i], cols[i]};
+        const float us[4] = {u2, u2, u, u};
+        const float vs[4] = {v, v2, v2, v};
+        put_textured_(buf, state_, 4, c4, xs, ys, us, vs);
+        buf->end_quad();
+    }
+}
+
+void brush::draw_rect(const quad& dst) {
     assert_mode(graph_mode::colored_quad);
+    auto buf = target_();
 
     float x = dst.x, y = dst.y, w = dst.width, h = dst.height;
-    float x1 = x, y1 = y, x2 = x + w, y2 = y + h;
-#ifdef ARC_BRUSH_CPU_TRANSFORM
-    auto& ts = tstack_.top();
-    ts.apply(x1, y1);
-    ts.apply(x2, y2);
-#endif
+    float xs[4], ys[4];
+    quad_corners_(x, y, x + w, y + h, xs, ys);
 
-    buf->vtx(x2).vtx(y2);
-    w_half_(buf, vertex_color[2]);
-    buf->vtx(x2).vtx(y1);
-    w_half_(buf, vertex_color[3]);
-    buf->vtx(x1).vtx(y1);
-    w_half_(buf, vertex_color[0]);
-    buf->vtx(x1).vtx(y2);
-    w_half_(buf, vertex_color[1]);
+    const color cols[4] = {vertex_color[2], vertex_color[3], vertex_color[0], vertex_color[1]};
+    put_colored_(buf, state_, 4, cols, xs, ys);
 
     buf->end_quad();
 }
@@ -343,59 +582,38 @@ void brush::draw_rect_outline(const quad& dst) {
 }
 
 void brush::draw_triagle(const vec2& p1, const vec2& p2, const vec2& p3) {
-    auto buf = wbuf;
-
     assert_mode(graph_mode::colored_triangle);
+    auto buf = target_();
 
-    float x1 = p1.x, y1 = p1.y, x2 = p2.x, y2 = p2.y, x3 = p3.x, y3 = p3.y;
-#ifdef ARC_BRUSH_CPU_TRANSFORM
-    auto& ts = tstack_.top();
-    ts.apply(x1, y1);
-    ts.apply(x2, y2);
-    ts.apply(x3, y3);
-#endif
+    float xs[3] = {static_cast<float>(p1.x), static_cast<float>(p2.x), static_cast<float>(p3.x)};
+    float ys[3] = {static_cast<float>(p1.y), static_cast<float>(p2.y), static_cast<float>(p3.y)};
+    for (int i = 0; i < 3; i++) apply_(xs[i], ys[i]);
 
-    buf->vtx(x1).vtx(y1);
-    w_half_(buf, vertex_color[0]);
-    buf->vtx(x2).vtx(y2);
-    w_half_(buf, vertex_color[1]);
-    buf->vtx(x3).vtx(y3);
-    w_half_(buf, vertex_color[2]);
+    put_colored_(buf, state_, 3, vertex_color, xs, ys);
     buf->new_vertex(3);
 }
 
 void brush::draw_line(const vec2& p1, const vec2& p2) {
-    auto buf = wbuf;
-
     assert_mode(graph_mode::colored_line);
+    auto buf = target_();
 
-    float x1 = p1.x, y1 = p1.y, x2 = p2.x, y2 = p2.y;
-#ifdef ARC_BRUSH_CPU_TRANSFORM
-    auto& ts = tstack_.top();
-    ts.apply(x1, y1);
-    ts.apply(x2, y2);
-#endif
+    float xs[2] = {static_cast<float>(p1.x), static_cast<float>(p2.x)};
+    float ys[2] = {static_cast<float>(p1.y), static_cast<float>(p2.y)};
+    apply_(xs[0], ys[0]);
+    apply_(xs[1], ys[1]);
 
-    buf->vtx(x1).vtx(y1);
-    w_half_(buf, vertex_color[0]);
-    buf->vtx(x2).vtx(y2);
-    w_half_(buf, vertex_color[1]);
+    put_colored_(buf, state_, 2, vertex_color, xs, ys);
     buf->new_vertex(2);
 }
 
 void brush::draw_point(const vec2& p) {
-    auto buf = wbuf;
-
     assert_mode(graph_mode::colored_point);
+    auto buf = target_();
 
     float x1 = p.x, y1 = p.y;
-#ifdef ARC_BRUSH_CPU_TRANSFORM
-    auto& ts = tstack_.top();
-    ts.apply(x1, y1);
-#endif
+    apply_(x1, y1);
 
-    buf->vtx(x1).vtx(y1);
-    w_half_(buf, vertex_color[0]);
+    put_colored_(buf, state_, 1, vertex_color, &x1, &y1);
     buf->new_vertex(1);
 }
 
@@ -478,11 +696,12 @@ void brush::scissor_end() {
 }
 
 void brush::use_blend(blend_mode mode) {
-    flush();
-    if (mode == blend_mode::normal)
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    else if (mode == blend_mode::add)
-        glBlendFunc(GL_SRC_ALPHA, GL_SRC_ALPHA);
+    // queued draws carry their blend mode.
+    if (cq_depth_ == 0) {
+        flush();
+        apply_blend_(mode);
+    }
+    blend_ = mode;
 }
 
 }  // namespace arc
\ No newline at end of file
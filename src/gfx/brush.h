@@ -10,13 +10,63 @@
 #include "gfx/shader.h"
 #include "gfx/state.h"
 
-// I've not found the solution, on how to correctly transform models on cpu.
-// that will significantly decrease draw-calls.
-// currently, keep it simple.
-// #define ARC_BRUSH_CPU_TRANSFORM
+// apply the transform stack to vertices as they are written, so transform changes do not break batches.
+// without it every ts_* call flushes and the transform goes to u_proj. meshes are always drawn the latter way.
+#define ARC_BRUSH_CPU_TRANSFORM
+// direct (immediate) flushes stream their vertices through one shared ring buffer instead of re-uploading the
+// buffer of the direct mesh. meshes drawn with #mesh::draw keep their own buffers.
+#define ARC_BRUSH_STREAM_RING
+// quads per draw call on the shared 16-bit quad index buffer, their 4 vertices each must fit in 16 bits.
+#define ARC_QUAD_INDEX_BATCH 16384
 
 namespace arc {
 
+// vertex of graph_mode::textured_quad, as the builtin textured program reads it.
+struct vertex_textured {
+    float x, y;
+    uint16_t col[4];
+    float u, v;
+};
+
+// vertex of the colored modes.
+struct vertex_colored {
+    float x, y;
+    uint16_t col[4];
+};
+
+// vertices of vertex_format::ldr.
+struct vertex_textured_ldr {
+    float x, y;
+    uint8_t col[4];
+    float u, v;
+};
+
+struct vertex_colored_ldr {
+    float x, y;
+    uint8_t col[4];
+};
+
+// textured vertex of vertex_format::compact, half the size of vertex_textured.
+struct vertex_compact {
+    int16_t x, y;
+    uint8_t col[4];
+    uint16_t u, v;
+};
+
+static_assert(sizeof(vertex_textured) == 24 && sizeof(vertex_colored) == 16 && sizeof(vertex_compact) == 12 &&
+                  sizeof(vertex_textured_ldr) == 20 && sizeof(vertex_colored_ldr) == 12,
+              "brush vertices must stay packed.");
+
+// a group of the command queue, queued draws with the same key are merged in here.
+struct brush_batch_ {
+    int layer = 0;
+    unsigned int program = 0;
+    unsigned int texture = 0;
+    blend_mode blend = blend_mode::normal;
+    graph_state state;
+    std::shared_ptr<mesh> target;
+};
+
 struct brush {
     color vertex_color[4]{};
     std::stack<transform> tstack_;
@@ -24,11 +74,29 @@ struct brush {
     graph_state state_;
     std::shared_ptr<program> default_colored_;
     std::shared_ptr<program> default_textured_;
+    std::shared_ptr<program> default_compact_;
+    std::shared_ptr<program> default_textured_ldr_;
+    std::shared_ptr<program> default_colored_ldr_;
     complex_buffer* wbuf = nullptr;
     mesh* mesh_root_ = nullptr;
     bool is_in_mesh_ = false;
     // when true, the brush will clear the buffer when flushed.
     bool clear_when_flush_ = true;
+#ifdef ARC_BRUSH_CPU_TRANSFORM
+    bool cpu_transform_ = true;
+#else
+    bool cpu_transform_ = false;
+#endif
+    blend_mode blend_ = blend_mode::normal;
+    // command queue, only the first #cq_used_ batches are valid.
+    int cq_depth_ = 0;
+    int cq_layer_ = 0;
+    std::vector<brush_batch_> cq_batches_;
+    int cq_used_ = 0;
+    int cq_last_ = -1;
+    // state and blend when the outermost queue opened, restored when it ends.
+    graph_state cq_saved_state_;
+    blend_mode cq_saved_blend_ = blend_mode::normal;
 
     brush();
 
@@ -46,8 +114,21 @@ struct brush {
     void ts_rot(double r);
     void ts_rot(const vec2& v, double r);
     transform get_combined_transform();
+    void apply_(float& x, float& y) const;
+    // corners of a rectangle through the transform, in the order quad vertices are written.
+    void quad_corners_(float x1, float y1, float x2, float y2, float* xs, float* ys) const;
 
     void flush();
+    // defer draws until #cq_end or the next flush. they are grouped by layer, program, texture and blend, then the
+    // groups are drawn in that order. draws keep their order within a group, across groups only the layer order holds.
+    // nests, the outermost #cq_end draws.
+    void cq_begin();
+    // queued draws after this are drawn after those of lower layers.
+    void cq_layer(int layer);
+    void cq_end();
+    // where the next vertices go, the wbuf or a queued batch.
+    complex_buffer* target_();
+    void cq_drain_();
     void assert_mode(graph_mode mode);
     void assert_texture(std::shared_ptr<texture> tex);
     void use_camera(const camera& cam);
@@ -56,6 +137,10 @@ struct brush {
 
     void draw_texture(std::shared_ptr<texture> tex, const quad& dst, const quad& src, uint8_t flag = brush_flag::NO);
     void draw_texture(std::shared_ptr<texture> tex, const quad& dst, uint8_t flag = brush_flag::NO);
+    // #count textured quads on the page of #tex, each with its own colour. #src is in texels of the whole page, not
+    // of #tex. the texture is asserted once, so a run of sprites on one page goes into one batch.
+    void draw_texture_run(const std::shared_ptr<texture>& tex, int count, const quad* dst, const quad* src,
+                          const color* cols);
     void draw_rect(const quad& dst);
     void draw_rect_outline(const quad& dst);
     void draw_triagle(const vec2& p1, const vec2& p2, const vec2& p3);
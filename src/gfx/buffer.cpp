@@ -1,4 +1,6 @@
 #include "gfx/buffer.h"
+
+#include <algorithm>
 #include <memory>
 
 #include "gfx/brush.h"
@@ -8,22 +10,52 @@ namespace arc {
 void complex_buffer::end_quad() {
     new_index(6);
     new_vertex(4);
+}
 
-    std::size_t s = sizeof(unsigned int) * 6;
-    std::size_t old = index_buf.size();
-    if (old + s > index_buf.capacity()) {
-        index_buf.reserve(index_buf.capacity() * 2);
-        icap_changed_ = true;
+uint8_t* complex_buffer::push_vertices(int count, int stride) {
+    size_t old = vertex_buf.size();
+    size_t s = static_cast<size_t>(count) * stride;
+    if (old + s > vertex_buf.capacity()) {
+        vertex_buf.reserve(std::max(vertex_buf.capacity() * 2, old + s));
+        vcap_changed_ = true;
     }
 
-    unsigned int k = vertex_count - 4;
-    // we don't use #idx to cut down 5 another cap checks.
-    index_buf.push_back(0 + k);
-    index_buf.push_back(1 + k);
-    index_buf.push_back(3 + k);
-    index_buf.push_back(1 + k);
-    index_buf.push_back(2 + k);
-    index_buf.push_back(3 + k);
+    vertex_buf.resize(old + s);
+    mark_dirty_(old, old + s);
+    return vertex_buf.data() + old;
+}
+
+void complex_buffer::append(const complex_buffer& other) {
+    size_t vold = vertex_buf.size();
+    size_t vs = other.vertex_buf.size();
+    if (vold + vs > vertex_buf.capacity()) {
+        vertex_buf.reserve(std::max(vertex_buf.capacity() * 2, vold + vs));
+        vcap_changed_ = true;
+    }
+    vertex_buf.insert(vertex_buf.end(), other.vertex_buf.begin(), other.vertex_buf.end());
+    mark_dirty_(vold, vold + vs);
+
+    vertex_count += other.vertex_count;
+    index_count += other.index_count;
+}
+
+void complex_buffer::pad_quads(int count, int stride) {
+    size_t old = vertex_buf.size();
+    size_t s = static_cast<size_t>(count) * 4 * stride;
+    if (old + s > vertex_buf.capacity()) {
+        vertex_buf.reserve(std::max(vertex_buf.capacity() * 2, old + s));
+        vcap_changed_ = true;
+    }
+
+    vertex_buf.resize(old + s, 0);
+    mark_dirty_(old, old + s);
+    for (int i = 0; i < count; i++) end_quad();
+}
+
+void complex_buffer::mark_dirty_(size_t lo, size_t hi) {
+    dirty_lo_ = std::min(dirty_lo_, lo);
+    dirty_hi_ = std::max(dirty_hi_, hi);
+    dirty = true;
 }
 
 void complex_buffer::new_vertex(int count) { vertex_count += count; }
@@ -32,10 +64,11 @@ void complex_buffer::new_index(int count) { index_count += count; }
 
 void complex_buffer::clear() {
     vertex_buf.clear();
-    index_buf.clear();
     vertex_count = 0;
     index_count = 0;
     dirty = true;
+    dirty_lo_ = 0;
+    dirty_hi_ = SIZE_MAX;
 }
 
 std::unique_ptr<brush> complex_buffer::derive_brush() {
@@ -1,5 +1,8 @@
 #pragma once
+#include <algorithm>
+#include <cstdint>
 #include <cstring>
+#include <memory>
 #include <vector>
 
 namespace arc {
@@ -7,15 +10,16 @@ namespace arc {
 struct brush;
 
 // currently it only supports quad-drawing indexing.
-// maybe in the future I'll extend it.
+// the indices are implied, quads share one index buffer at draw time (see brush#flush), only the count is kept.
 struct complex_buffer {
     std::vector<uint8_t> vertex_buf;
-    std::vector<unsigned int> index_buf;
     int vertex_count = 0;
     int index_count = 0;
     bool dirty;
-    bool icap_changed_;
     bool vcap_changed_;
+    // byte range of #vertex_buf changed since the last upload.
+    size_t dirty_lo_ = 0;
+    size_t dirty_hi_ = SIZE_MAX;
 
     // write a vertex, generally, T is float.
     template <typename T>
@@ -23,35 +27,36 @@ struct complex_buffer {
         size_t s = sizeof(t);
         size_t old = vertex_buf.size();
         if (old + s > vertex_buf.capacity()) {
-            vertex_buf.reserve(vertex_buf.capacity() * 2);
+            vertex_buf.reserve(std::max(vertex_buf.capacity() * 2, old + s));
             vcap_changed_ = true;
         }
-     
+
         vertex_buf.resize(old + s);
         std::memcpy(vertex_buf.data() + old, &t, s);
-        dirty = true;
+        mark_dirty_(old, old + s);
 
         return *this;
     }
 
-    // write an index.
-    inline complex_buffer& idx(unsigned int t) {
-        size_t s = sizeof(t);
-        size_t old = index_buf.size();
-        if (old + s > index_buf.capacity()) {
-            index_buf.reserve(index_buf.capacity() * 2);
-            icap_changed_ = true;
-        }
-
-        index_buf.push_back(t);
-        dirty = true;
-
-        return *this;
+    // make room for #count vertices of #stride bytes at the end and return them to be written in place.
+    // the storage grows geometrically, the pointer is valid until the next write.
+    // the vertices are not counted, #end_quad or #new_vertex does that.
+    uint8_t* push_vertices(int count, int stride);
+    // typed version of #push_vertices, V is a plain vertex struct.
+    template <typename V>
+    V* push_vertices(int count) {
+        return reinterpret_cast<V*>(push_vertices(count, sizeof(V)));
     }
 
     void new_vertex(int count);
     void new_index(int count);
     void end_quad();
+    // append the vertices of another buffer.
+    void append(const complex_buffer& other);
+    // write count zeroed quads of stride-byte vertices, they are degenerate and draw nothing.
+    void pad_quads(int count, int stride);
+    // mark bytes [lo, hi) of #vertex_buf as changed, only that range will be uploaded if the capacity holds.
+    void mark_dirty_(size_t lo, size_t hi);
     void clear();
     std::unique_ptr<brush> derive_brush();
 
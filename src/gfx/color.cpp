@@ -1,5 +1,13 @@
 #include "gfx/color.h"
 
+#include <algorithm>
+#include <cstring>
+
+#if defined(__F16C__) || defined(__AVX2__)
+#define ARC_F16C
+#include <immintrin.h>
+#endif
+
 namespace arc {
 
 color color::from_bytes(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
@@ -63,4 +71,62 @@ color color::hsv(float hue, float saturation, float value) {
     return color(f4, f5, f6);
 }
 
+#ifndef ARC_F16C
+// float to half, round to nearest even, the same as vcvtps2ph.
+static uint16_t half_of_(float f) {
+    uint32_t x;
+    std::memcpy(&x, &f, 4);
+    uint32_t sign = (x >> 16) & 0x8000;
+    uint32_t ax = x & 0x7FFFFFFF;
+
+    // inf and nan, nans stay quiet.
+    if (ax >= 0x7F800000) return sign | 0x7C00 | (ax > 0x7F800000 ? 0x200 | ((ax & 0x7FFFFF) >> 13) : 0);
+    // rounds up past the largest half.
+    if (ax >= 0x477FF000) return sign | 0x7C00;
+    // subnormal halves.
+    if (ax < 0x38800000) {
+        if (ax < 0x33000000) return sign;
+        uint32_t m = (ax & 0x7FFFFF) | 0x800000;
+        uint32_t shift = 126 - (ax >> 23);
+        uint32_t h = m >> shift;
+        uint32_t rem = m & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rem > halfway || (rem == halfway && (h & 1))) h++;
+        return sign | h;
+    }
+
+    uint32_t r = ax - 0x38000000;
+    uint32_t h = r >> 13;
+    uint32_t rem = r & 0x1FFF;
+    if (rem > 0x1000 || (rem == 0x1000 && (h & 1))) h++;
+    return sign | h;
+}
+#endif
+
+void pack_half4(const color* cols, int n, uint16_t* out) {
+    for (int i = 0; i < n; i++) {
+        const color& c = cols[i];
+#ifdef ARC_F16C
+        __m128 f = _mm_setr_ps(c.r, c.g, c.b, c.a);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i * 4), _mm_cvtps_ph(f, _MM_FROUND_TO_NEAREST_INT));
+#else
+        out[i * 4 + 0] = half_of_(c.r);
+        out[i * 4 + 1] = half_of_(c.g);
+        out[i * 4 + 2] = half_of_(c.b);
+        out[i * 4 + 3] = half_of_(c.a);
+#endif
+    }
+}
+
+static inline uint8_t unorm8_of_(double v) { return static_cast<uint8_t>(std::clamp(v, 0.0, 1.0) * 255.0 + 0.5); }
+
+void pack_unorm4(const color* cols, int n, uint8_t* out) {
+    for (int i = 0; i < n; i++) {
+        out[i * 4 + 0] = unorm8_of_(cols[i].r);
+        out[i * 4 + 1] = unorm8_of_(cols[i].g);
+        out[i * 4 + 2] = unorm8_of_(cols[i].b);
+        out[i * 4 + 3] = unorm8_of_(cols[i].a);
+    }
+}
+
 }  // namespace arc
\ No newline at end of file
@@ -43,4 +43,10 @@ struct color {
     static color hsv(float hue, float saturation, float value);
 };
 
+// pack #n colours into rgba half floats, rounded to nearest even. uses f16c when the build targets it, the scalar
+// path gives the same bits.
+void pack_half4(const color* cols, int n, uint16_t* out);
+// pack #n colours into rgba unorm8, clamped to [0, 1].
+void pack_unorm4(const color* cols, int n, uint8_t* out);
+
 }  // namespace arc
\ No newline at end of file
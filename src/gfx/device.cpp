@@ -7,14 +7,11 @@
 #include "core/key.h"
 #include "core/log.h"
 #include "core/time.h"
+#include "gfx/gl.h"
 #include "gfx/image.h"
 #include "gfx/mesh.h"
 
-// clang-format off
-#include <gl/glew.h>
-#include <gl/gl.h>
 #include <glfw/glfw3.h>
-// clang-format on
 
 namespace arc {
 
@@ -166,6 +163,7 @@ void tk_end_make_handle() { glfwShowWindow(window); }
 std::string tk_get_title() { return glfwGetWindowTitle(window); }
 
 vec2 tk_get_size() {
+    if (window == nullptr) return vec2(ARC_HEADLESS_WIDTH, ARC_HEADLESS_HEIGHT);
     int w, h;
     glfwGetWindowSize(window, &w, &h);
     return vec2(w, h);
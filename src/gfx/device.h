@@ -6,6 +6,10 @@
 #include "gfx/brush.h"
 #include "gfx/image.h"
 
+// the size reported when there is no window, as with the null gl backend.
+#define ARC_HEADLESS_WIDTH 800
+#define ARC_HEADLESS_HEIGHT 450
+
 namespace arc {
 
 struct brush;
@@ -4,13 +4,9 @@
 
 #include "core/log.h"
 #include "gfx/device.h"
+#include "gfx/gl.h"
 #include "gfx/image.h"
 
-// clang-format off
-#include <gl/glew.h>
-#include <gl/gl.h>
-// clang-format on
-
 namespace arc {
 
 static int fb_idic = 0;
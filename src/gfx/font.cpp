@@ -1,9 +1,15 @@
 #include "gfx/font.h"
 
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
 #include "core/chcvt.h"
 #include "core/io.h"
-#include "gfx/atlas.h"
+#include "core/thrp.h"
 #include "gfx/brush.h"
+#include "gfx/glyph_atlas.h"
 #include "gfx/image.h"
 
 // clang-format off
@@ -13,10 +19,29 @@
 
 namespace arc {
 
+// a glyph rasterized but not placed on a page yet.
+struct glyph_bitmap_ {
+    char32_t ch;
+    int width, height;
+    std::vector<uint8_t> pixels;
+    vec2 size;
+    double advance;
+    vec2 offset;
+};
+
+// bitmaps done by the prewarm workers, taken by the render thread.
+struct prewarm_queue_ {
+    std::mutex mtx;
+    std::vector<glyph_bitmap_> ready;
+    std::atomic<bool> any{false};
+};
+
 struct font::impl_ {
     FT_FaceRec_* face_ptr;
     FT_LibraryRec_* lib_ptr;
-    std::unordered_map<int, std::shared_ptr<atlas>> codemap;
+    std::string face_path;
+    std::shared_ptr<glyph_atlas> atlas;
+    std::shared_ptr<prewarm_queue_> prewarm = std::make_shared<prewarm_queue_>();
     double res, pix;
     bool filter_smth;
 };
@@ -28,145 +53,233 @@ font::~font() {
     FT_Done_FreeType(pimpl_->lib_ptr);
 }
 
-std::shared_ptr<texture> flush_codemap_(font::impl_* p_, char32_t ch, std::shared_ptr<image> img) {
-    int code = static_cast<int>(std::floor(static_cast<int>(ch) / 256.0));
-    if (p_->codemap.find(code) == p_->codemap.end()) {
-        int ats = p_->res * 16;
-        p_->codemap[code] = atlas::make(ats, ats);
-        p_->codemap[code]->begin();
-    }
-
-    auto atl = p_->codemap[code];
-    auto tptr = atl->accept(img);
-    atl->end();
-    return tptr;
-}
-
-glyph font::make_glyph(char32_t ch) {
-    auto face = pimpl_->face_ptr;
+// a face is not thread safe, every thread rasterizes with a face of its own.
+static glyph_bitmap_ rasterize_(FT_FaceRec_* face, double res, double pix, double height, char32_t ch) {
     unsigned int idx = FT_Get_Char_Index(face, ch);
 
-    FT_Set_Pixel_Sizes(face, 0, pimpl_->res);
+    FT_Set_Pixel_Sizes(face, 0, res);
     FT_Load_Glyph(face, idx, FT_LOAD_DEFAULT);
     FT_Render_Glyph(face->glyph, FT_RENDER_MODE_NORMAL);
     FT_Bitmap_ m0 = face->glyph->bitmap;
 
-    int len = static_cast<int>(m0.width * m0.rows * 4);
-    uint8_t* buf = new uint8_t[len];
-    for (int i = 0; i < len; i += 4) {
-        uint8_t grey = m0.buffer[i / 4];
-        buf[i + 0] = 255;
-        buf[i + 1] = 255;
-        buf[i + 2] = 255;
-        buf[i + 3] = grey;
-    }
-
-    std::shared_ptr<image> img =
-        image::make(static_cast<int>(face->glyph->bitmap.width), static_cast<int>(face->glyph->bitmap.rows), buf);
-
-    double ds = pimpl_->res / pimpl_->pix;
-
-    glyph g;
-    g.texpart = flush_codemap_(pimpl_.get(), ch, img);
-    texture_parameters pms;
-    if (pimpl_->filter_smth)
-        pms = texture_parameters(texture_parameter::uv_clamp, texture_parameter::filter_linear,
-                                 texture_parameter::filter_linear);
-    else
-        pms = texture_parameters(texture_parameter::uv_clamp, texture_parameter::filter_nearest,
-                                 texture_parameter::filter_nearest);
-    g.texpart->parameters(pms);
-    g.size.x = ch == ' ' ? face->glyph->metrics.horiAdvance / ds / 64.0 : face->glyph->metrics.width / ds / 64.0;
-    g.size.y = face->glyph->metrics.height / ds / 64.0;
-    g.advance = face->glyph->advance.x / ds / 64.0;
-    g.offset.x = face->glyph->metrics.horiBearingX / ds / 64.0;
+    glyph_bitmap_ bm;
+    bm.ch = ch;
+    bm.width = static_cast<int>(m0.width);
+    bm.height = static_cast<int>(m0.rows);
+    bm.pixels.resize(static_cast<size_t>(bm.width) * bm.height);
+    for (int r = 0; r < bm.height; r++)
+        std::memcpy(bm.pixels.data() + r * bm.width, m0.buffer + r * m0.pitch, bm.width);
+
+    double ds = res / pix;
+    auto& mt = face->glyph->metrics;
+    bm.size.x = ch == ' ' ? mt.horiAdvance / ds / 64.0 : mt.width / ds / 64.0;
+    bm.size.y = mt.height / ds / 64.0;
+    bm.advance = face->glyph->advance.x / ds / 64.0;
+    bm.offset.x = mt.horiBearingX / ds / 64.0;
 #ifdef ARC_Y_IS_DOWN
-    g.offset.y = -face->glyph->metrics.horiBearingY / ds / 64.0 + height + face->bbox.yMin / ds / 64.0;
+    bm.offset.y = -mt.horiBearingY / ds / 64.0 + height + face->bbox.yMin / ds / 64.0;
 #else
-    g.offset.y = face->glyph->metrics.horiBearingY / ds / 64.0 - g.size.y;
+    bm.offset.y = mt.horiBearingY / ds / 64.0 - bm.size.y;
 #endif
+    return bm;
+}
 
+// put the bitmap on a page, without #evict it fails when the pages are full.
+static bool place_(glyph_atlas* atl, const glyph_bitmap_& bm, bool evict, glyph* out) {
+    int page;
+    auto tex = atl->place(bm.ch, bm.width, bm.height, bm.pixels.data(), &page, evict);
+    if (tex == nullptr) return false;
+    *out = {tex, bm.size, bm.advance, bm.offset, page};
+    return true;
+}
+
+glyph font::make_glyph(char32_t ch) {
+    glyph g;
+    place_(pimpl_->atlas.get(), rasterize_(pimpl_->face_ptr, pimpl_->res, pimpl_->pix, height, ch), true, &g);
     return g;
 }
 
-font_render_bound font::make_vtx(brush* brush, const std::string& u8_str, double x, double y, long align, double max_w,
-                                 double scale) {
-    static std::u32string cvtbuf_;
-    cvt_u32_(u8_str, &cvtbuf_);
-    return make_vtx(brush, cvtbuf_, x, y, align, max_w, scale);
+void font::prewarm(const std::u32string& charset) {
+    std::string path_ = pimpl_->face_path;
+    double res = pimpl_->res, pix = pimpl_->pix, h = height;
+    std::shared_ptr<prewarm_queue_> queue = pimpl_->prewarm;
+
+    thread_pool::execute([=]() {
+        FT_LibraryRec_* lib;
+        FT_FaceRec_* face;
+        if (FT_Init_FreeType(&lib) != 0) return;
+        if (FT_New_Face(lib, path_.c_str(), 0, &face) != 0) {
+            FT_Done_FreeType(lib);
+            return;
+        }
+        FT_Select_Charmap(face, FT_ENCODING_UNICODE);
+
+        // handed over in small groups, so the first glyphs are usable early.
+        std::vector<glyph_bitmap_> done;
+        for (size_t i = 0; i < charset.length(); i++) {
+            done.push_back(rasterize_(face, res, pix, h, charset[i]));
+            if (done.size() == 64 || i == charset.length() - 1) {
+                std::lock_guard lk(queue->mtx);
+                for (auto& bm : done) queue->ready.push_back(std::move(bm));
+                queue->any.store(true, std::memory_order_release);
+                done.clear();
+            }
+        }
+
+        FT_Done_Face(face);
+        FT_Done_FreeType(lib);
+    });
 }
 
-font_render_bound font::make_vtx(brush* brush, const std::u32string& str, double x, double y, long align, double max_w,
-                                 double scale) {
-    if (str.length() == 0 || str.length() > INT16_MAX) return {};
-
-    if (align & font_align::left && align & font_align::up) {
-        double h_scaled = scale * lspc;
-        double w = 0;
-        double lw = 0;
-        double h = 0;
-        double lh = 0;
-        double dx = x;
-        double dy = y;
-        bool endln = false;
-        int lns = 1;
-
-        for (int i = 0; i < static_cast<int>(str.length()); i++) {
-            char32_t ch = str[i];
-
-            if (ch == '\n' || endln) {
+void font::drain_prewarm_() {
+    prewarm_queue_& queue = *pimpl_->prewarm;
+    if (!queue.any.load(std::memory_order_acquire)) return;
+
+    std::vector<glyph_bitmap_> ready;
+    {
+        std::lock_guard lk(queue.mtx);
+        ready.swap(queue.ready);
+        queue.any.store(false, std::memory_order_relaxed);
+    }
+
+    for (auto& bm : ready) {
+        char32_t ch = bm.ch;
+        if (ch < 128 ? ascii_made_[ch] : glyph_map.count(ch) != 0) continue;
+        // prewarmed glyphs never push drawn ones out, they are made again lazily if needed.
+        glyph g;
+        if (!place_(pimpl_->atlas.get(), bm, false, &g)) continue;
+        if (ch < 128) {
+            ascii_glyphs_[ch] = g;
+            ascii_made_[ch] = true;
+        } else {
+            glyph_map.emplace(ch, g);
+        }
+    }
+}
+
+font_layout font::layout(const std::u32string& str, long align, double max_w, double scale) {
+    font_layout lay;
+    if (str.length() == 0 || str.length() > INT16_MAX) return lay;
+    drain_prewarm_();
+
+    double h_scaled = scale * lspc;
+    double w = 0;
+    double lw = 0;
+    double h = 0;
+    double lh = 0;
+    double dx = 0;
+    double dy = 0;
+    bool endln = false;
+    int lns = 1;
+    lay.glyphs.reserve(str.length());
+
+    for (int i = 0; i < static_cast<int>(str.length()); i++) {
+        char32_t ch = str[i];
+
+        if (ch == '\n' || endln) {
 #ifdef ARC_Y_IS_DOWN
-                dy += h_scaled;
+            dy += h_scaled;
 #else
-                dy -= h_scaled;
+            dy -= h_scaled;
 #endif
-                dx = x;
-                endln = false;
-                w = std::max(w, lw);
-                lw = 0;
-                h += h_scaled;
-                lh = 0;
-                lns++;
-                continue;
-            }
+            dx = 0;
+            endln = false;
+            w = std::max(w, lw);
+            lw = 0;
+            h += h_scaled;
+            lh = 0;
+            lns++;
+            continue;
+        }
 
-            glyph g = get_glyph(ch) * scale;
+        glyph g = get_glyph(ch) * scale;
+        // the page may not be evicted while this layout still refers to it.
+        pimpl_->atlas->touch(g.page_);
 
-            if (dx - x + g.advance >= max_w) {
-                endln = true;
-                i -= 1;
-                i = std::max(0, i - 1);
-                continue;
-            }
+        if (dx + g.advance >= max_w) {
+            endln = true;
+            i -= 1;
+            i = std::max(0, i - 1);
+            continue;
+        }
 
-            lh = std::max(g.size.y, lh);
-            lw += g.advance;
+        lh = std::max(g.size.y, lh);
+        lw += g.advance;
 
-            if (brush != nullptr)
-                brush->draw_texture(g.texpart, {dx + g.offset.x, dy + g.offset.y, g.size.x, g.size.y});
-            dx += g.advance;
+        lay.glyphs.push_back({g.texpart, {dx + g.offset.x, dy + g.offset.y, g.size.x, g.size.y}, g.page_});
+        dx += g.advance;
 
-            if (i == static_cast<int>(str.length()) - 1 || (get_glyph(str[i + 1]) * scale).advance + dx - x >= max_w)
-                lw += g.size.x - g.advance;
-        }
+        if (i == static_cast<int>(str.length()) - 1 || get_glyph(str[i + 1]).advance * scale + dx >= max_w)
+            lw += g.size.x - g.advance;
+    }
 
 #ifdef ARC_Y_IS_DOWN
-        return font_render_bound(quad::corner(x, y, std::max(lw, w), h + height * scale), lw, lns);
+    lay.bound = font_render_bound(quad::corner(0, 0, std::max(lw, w), h + height * scale), lw, lns);
 #else
-        return font_render_bound(quad::corner(x, dy, std::max(lw, w), h + f_height * scale), lw, lns);
+    lay.bound = font_render_bound(quad::corner(0, dy, std::max(lw, w), h + f_height * scale), lw, lns);
 #endif
+
+    // align the positions, the layout is only shifted.
+    double ax = 0, ay = 0;
+    double bw = lay.bound.region.width, bh = lay.bound.region.height;
+    if (align & font_align::down) ay -= bh;
+    if (align & font_align::vert_center) ay -= bh / 2;
+    if (align & font_align::right) ax -= bw;
+    if (align & font_align::hori_center) ax -= bw / 2;
+
+    if (ax != 0 || ay != 0) {
+        for (auto& pg : lay.glyphs) pg.dst.translate(ax, ay);
+        lay.bound.region.translate(ax, ay);
     }
+    return lay;
+}
 
-    // align the positions
-    auto qd = make_vtx(nullptr, str, x, y, font_align::normal, max_w, scale);
-    double w = qd.region.width, h = qd.region.height;
+const font_layout& font::layout_cached(const std::string& u8_str, long align, double max_w, double scale) {
+    // the key is the string followed by the raw layout arguments.
+    static std::string key_;
+    key_.assign(u8_str);
+    key_.append(reinterpret_cast<const char*>(&align), sizeof(align));
+    key_.append(reinterpret_cast<const char*>(&max_w), sizeof(max_w));
+    key_.append(reinterpret_cast<const char*>(&scale), sizeof(scale));
 
-    if (align & font_align::down) y -= h;
-    if (align & font_align::vert_center) y -= h / 2;
-    if (align & font_align::right) x -= w;
-    if (align & font_align::hori_center) x -= w / 2;
+    auto it = layout_cache_.find(key_);
+    if (it != layout_cache_.end()) return it->second;
 
-    return make_vtx(brush, str, x, y, font_align::normal, max_w, scale);
+    static std::u32string cvtbuf_;
+    cvt_u32_(u8_str, &cvtbuf_);
+    // text that changes every frame would grow the cache without bound.
+    if (layout_cache_.size() >= ARC_FONT_LAYOUT_CACHE) layout_cache_.clear();
+    return layout_cache_.emplace(key_, layout(cvtbuf_, align, max_w, scale)).first->second;
+}
+
+font_render_bound font::draw_layout(brush* brush, const font_layout& lay, double x, double y) {
+    if (lay.bound.lines == 0) return {};
+
+    if (brush != nullptr && !lay.glyphs.empty()) {
+        // new glyphs of all the pages go up at once, before they are drawn.
+        pimpl_->atlas->upload();
+        // glyphs never overlap, so the pages can be drawn in any order.
+        brush->cq_begin();
+        for (auto& pg : lay.glyphs) {
+            pimpl_->atlas->touch(pg.page_);
+            brush->draw_texture(pg.texpart, {x + pg.dst.x, y + pg.dst.y, pg.dst.width, pg.dst.height});
+        }
+        brush->cq_end();
+    }
+
+    font_render_bound bd = lay.bound;
+    bd.region.translate(x, y);
+    return bd;
+}
+
+font_render_bound font::make_vtx(brush* brush, const std::string& u8_str, double x, double y, long align, double max_w,
+                                 double scale) {
+    return draw_layout(brush, layout_cached(u8_str, align, max_w, scale), x, y);
+}
+
+font_render_bound font::make_vtx(brush* brush, const std::u32string& str, double x, double y, long align, double max_w,
+                                 double scale) {
+    return draw_layout(brush, layout(str, align, max_w, scale), x, y);
 }
 
 std::shared_ptr<font> font::load(const path& path_, double h, font_style style) {
@@ -180,6 +293,7 @@ std::shared_ptr<font> font::load(const path& path_, double h, font_style style)
 
     fptr->pimpl_->face_ptr = face;
     fptr->pimpl_->lib_ptr = lib;
+    fptr->pimpl_->face_path = path_.strp;
     fptr->pimpl_->res = style == font_style::regular ? h * ARC_FONT_RES_SCALE : h;
     fptr->pimpl_->pix = h;
     fptr->pimpl_->filter_smth = style == font_style::regular;
@@ -188,6 +302,27 @@ std::shared_ptr<font> font::load(const path& path_, double h, font_style style)
     fptr->descend = face->descender / 64.0;
     fptr->lspc = h + 1;
 
+    texture_parameter filter =
+        style == font_style::regular ? texture_parameter::filter_linear : texture_parameter::filter_nearest;
+    fptr->pimpl_->atlas = glyph_atlas::make(ARC_GLYPH_PAGE_SIZE, ARC_GLYPH_PAGE_LIMIT,
+                                            texture_parameters(texture_parameter::uv_clamp, filter, filter));
+    font* self = fptr.get();
+    fptr->pimpl_->atlas->on_evict = [self](const std::vector<char32_t>& chars) {
+        for (char32_t ch : chars) {
+            if (ch < 128)
+                self->ascii_made_[ch] = false;
+            else
+                self->glyph_map.erase(ch);
+        }
+        // cached layouts point into the evicted page.
+        self->layout_cache_.clear();
+    };
+
+    std::u32string charset;
+    for (char32_t ch = 32; ch < 127; ch++) charset += ch;
+    charset += ARC_FONT_PREWARM_CHARSET;
+    fptr->prewarm(charset);
+
     return fptr;
 }
 
@@ -1,5 +1,7 @@
 #pragma once
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "core/io.h"
 #include "core/math.h"
@@ -7,6 +9,10 @@
 #include "gfx/image.h"
 
 #define ARC_FONT_RES_SCALE 4
+// laid out strings kept per font, the cache is dropped as a whole when it grows past this.
+#define ARC_FONT_LAYOUT_CACHE 256
+// rasterized on a worker when a font is loaded, next to the printable ascii.
+#define ARC_FONT_PREWARM_CHARSET U""
 
 namespace arc {
 
@@ -27,14 +33,17 @@ struct glyph {
     vec2 size;
     double advance;
     vec2 offset;
+    // the glyph atlas page the texture is on.
+    /* unstable */ int page_ = -1;
 
     // scale the glyph.
-    inline glyph operator*(double scl) {
+    inline glyph operator*(double scl) const {
         return {
             texpart,
             size * scl,
             advance * scl,
             offset * scl,
+            page_,
         };
     }
 };
@@ -45,6 +54,19 @@ struct font_render_bound {
     int lines;
 };
 
+// a glyph quad placed by the layout, relative to the origin the text is drawn at.
+struct placed_glyph {
+    std::shared_ptr<texture> texpart;
+    quad dst;
+    int page_;
+};
+
+// a string laid out once, it can be drawn anywhere by translating it.
+struct font_layout {
+    std::vector<placed_glyph> glyphs;
+    font_render_bound bound;
+};
+
 enum class font_style { regular, pixel };
 
 struct font {
@@ -57,15 +79,40 @@ struct font {
     double ascend = 0;
     double descend = 0;
 
+    // ascii glyphs are kept densely, out of #glyph_map.
+    glyph ascii_glyphs_[128];
+    bool ascii_made_[128] = {};
+    std::unordered_map<std::string, font_layout> layout_cache_;
+
     font();
     ~font();
 
-    glyph get_glyph(char32_t ch) {
-        if (glyph_map.find(ch) == glyph_map.end()) return glyph_map[ch] = make_glyph(ch);
-        return glyph_map[ch];
+    const glyph& get_glyph(char32_t ch) {
+        if (ch < 128) {
+            if (!ascii_made_[ch]) {
+                ascii_glyphs_[ch] = make_glyph(ch);
+                ascii_made_[ch] = true;
+            }
+            return ascii_glyphs_[ch];
+        }
+        auto it = glyph_map.find(ch);
+        if (it == glyph_map.end()) it = glyph_map.emplace(ch, make_glyph(ch)).first;
+        return it->second;
     }
 
     glyph make_glyph(char32_t ch);
+    // rasterize the characters on a worker thread, they are placed into the atlas as they are done.
+    void prewarm(const std::u32string& charset);
+    // take the glyphs the workers have done, called before laying out.
+    void drain_prewarm_();
+    // lay the string out with its origin at (0, 0), the arguments are the same as #make_vtx.
+    font_layout layout(const std::u32string& str, long align = font_align::normal, double max_w = INT_MAX,
+                       double scale = 1);
+    // the layout of an utf-8 string, only laid out when it is not cached yet.
+    const font_layout& layout_cached(const std::string& u8_str, long align = font_align::normal,
+                                     double max_w = INT_MAX, double scale = 1);
+    // draw a layout with its origin at (x, y), return the bounding box.
+    font_render_bound draw_layout(brush* brush, const font_layout& lay, double x, double y);
     // draw the stringin the font, return the bounding box.
     // and if brush is nullptr, it won't draw anything, just calculating the
     // bounding box.
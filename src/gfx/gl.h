@@ -0,0 +1,30 @@
+#pragma once
+
+// the one place gl comes from. with ARC_NULL_GL the calls go to a backend that records them instead of rendering,
+// so the cpu side of rendering can be measured without a gpu.
+#ifdef ARC_NULL_GL
+#include "gfx/gl_null.h"
+#else
+// clang-format off
+#include <gl/glew.h>
+#include <gl/gl.h>
+// clang-format on
+#endif
+
+namespace arc {
+
+// what the null backend was asked to do, it stays zero with a real backend.
+struct gl_record {
+    long draw_calls = 0;
+    // vertices submitted, an indexed draw counts its indices.
+    long vertices = 0;
+    long bytes_uploaded = 0;
+    // binds, program and blend switches, capability toggles and uniforms.
+    long state_changes = 0;
+
+    void reset() { *this = {}; }
+};
+
+inline gl_record gl_recorded;
+
+}  // namespace arc
@@ -0,0 +1,112 @@
+#ifdef ARC_NULL_GL
+
+#include "gfx/gl.h"
+
+// every object name is unique, nothing is ever freed.
+static GLuint next_name_ = 1;
+
+static void gen_(GLsizei n, GLuint* out) {
+    for (GLsizei i = 0; i < n; i++) out[i] = next_name_++;
+}
+
+static void state_() { arc::gl_recorded.state_changes++; }
+
+static void draw_(long vertices) {
+    arc::gl_recorded.draw_calls++;
+    arc::gl_recorded.vertices += vertices;
+}
+
+static long texel_bytes_(GLenum format) { return format == GL_RED ? 1 : 4; }
+
+GLenum glewInit() { return GLEW_OK; }
+GLenum glGetError() { return GL_NO_ERROR; }
+
+void glEnable(GLenum) { state_(); }
+void glDisable(GLenum) { state_(); }
+void glBlendFunc(GLenum, GLenum) { state_(); }
+void glScissor(GLint, GLint, GLsizei, GLsizei) { state_(); }
+void glViewport(GLint, GLint, GLsizei, GLsizei) { state_(); }
+void glClearColor(GLfloat, GLfloat, GLfloat, GLfloat) { state_(); }
+void glClear(GLbitfield) {}
+void glPixelStorei(GLenum, GLint) {}
+void glDebugMessageCallback(GLDEBUGPROC, const void*) {}
+void glDebugMessageControl(GLenum, GLenum, GLenum, GLsizei, const GLuint*, GLboolean) {}
+
+void glGenBuffers(GLsizei n, GLuint* buffers) { gen_(n, buffers); }
+void glDeleteBuffers(GLsizei, const GLuint*) {}
+void glBindBuffer(GLenum, GLuint) { state_(); }
+void glBufferData(GLenum, GLsizeiptr size, const void* data, GLenum) {
+    if (data != nullptr) arc::gl_recorded.bytes_uploaded += size;
+}
+void glBufferSubData(GLenum, GLintptr, GLsizeiptr size, const void*) { arc::gl_recorded.bytes_uploaded += size; }
+void glBufferStorage(GLenum, GLsizeiptr size, const void* data, GLbitfield) {
+    if (data != nullptr) arc::gl_recorded.bytes_uploaded += size;
+}
+// nothing can be mapped, callers fall back to uploads.
+void* glMapBufferRange(GLenum, GLintptr, GLsizeiptr, GLbitfield) { return nullptr; }
+GLboolean glUnmapBuffer(GLenum) { return GL_TRUE; }
+GLsync glFenceSync(GLenum, GLbitfield) { return nullptr; }
+GLenum glClientWaitSync(GLsync, GLbitfield, GLuint64) { return GL_ALREADY_SIGNALED; }
+void glDeleteSync(GLsync) {}
+void glGenVertexArrays(GLsizei n, GLuint* arrays) { gen_(n, arrays); }
+void glDeleteVertexArrays(GLsizei, const GLuint*) {}
+void glBindVertexArray(GLuint) { state_(); }
+void glEnableVertexAttribArray(GLuint) {}
+void glVertexAttribPointer(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*) {}
+void glVertexAttribDivisor(GLuint, GLuint) {}
+
+void glGenTextures(GLsizei n, GLuint* textures) { gen_(n, textures); }
+void glDeleteTextures(GLsizei, const GLuint*) {}
+void glActiveTexture(GLenum) { state_(); }
+void glBindTexture(GLenum, GLuint) { state_(); }
+void glTexParameteri(GLenum, GLenum, GLint) {}
+void glTexParameteriv(GLenum, GLenum, const GLint*) {}
+void glTexImage2D(GLenum, GLint, GLint, GLsizei width, GLsizei height, GLint, GLenum format, GLenum,
+                  const void* pixels) {
+    if (pixels != nullptr) arc::gl_recorded.bytes_uploaded += static_cast<long>(width) * height * texel_bytes_(format);
+}
+void glTexSubImage2D(GLenum, GLint, GLint, GLint, GLsizei width, GLsizei height, GLenum format, GLenum,
+                     const void*) {
+    arc::gl_recorded.bytes_uploaded += static_cast<long>(width) * height * texel_bytes_(format);
+}
+
+void glGenFramebuffers(GLsizei n, GLuint* framebuffers) { gen_(n, framebuffers); }
+void glDeleteFramebuffers(GLsizei, const GLuint*) {}
+void glBindFramebuffer(GLenum, GLuint) { state_(); }
+void glFramebufferTexture2D(GLenum, GLenum, GLenum, GLuint, GLint) {}
+GLenum glCheckFramebufferStatus(GLenum) { return GL_FRAMEBUFFER_COMPLETE; }
+
+GLuint glCreateShader(GLenum) { return next_name_++; }
+void glDeleteShader(GLuint) {}
+void glShaderSource(GLuint, GLsizei, const GLchar* const*, const GLint*) {}
+void glCompileShader(GLuint) {}
+void glGetShaderiv(GLuint, GLenum, GLint* params) { *params = GL_TRUE; }
+void glGetShaderInfoLog(GLuint, GLsizei size, GLsizei* length, GLchar* log) {
+    if (size > 0) log[0] = '\0';
+    if (length != nullptr) *length = 0;
+}
+GLuint glCreateProgram() { return next_name_++; }
+void glDeleteProgram(GLuint) {}
+void glAttachShader(GLuint, GLuint) {}
+void glDetachShader(GLuint, GLuint) {}
+void glBindFragDataLocation(GLuint, GLuint, const GLchar*) {}
+void glLinkProgram(GLuint) {}
+void glValidateProgram(GLuint) {}
+void glUseProgram(GLuint) { state_(); }
+// locations only have to be valid, they are never looked at.
+GLint glGetUniformLocation(GLuint, const GLchar*) { return 0; }
+GLint glGetAttribLocation(GLuint, const GLchar*) { return 0; }
+void glUniform1i(GLint, GLint) { state_(); }
+void glUniform1f(GLint, GLfloat) { state_(); }
+void glUniform2f(GLint, GLfloat, GLfloat) { state_(); }
+void glUniform3f(GLint, GLfloat, GLfloat, GLfloat) { state_(); }
+void glUniform4f(GLint, GLfloat, GLfloat, GLfloat, GLfloat) { state_(); }
+void glUniformMatrix4fv(GLint, GLsizei, GLboolean, const GLfloat*) { state_(); }
+
+void glDrawArrays(GLenum, GLint, GLsizei count) { draw_(count); }
+void glDrawArraysInstanced(GLenum, GLint, GLsizei count, GLsizei instances) {
+    draw_(static_cast<long>(count) * instances);
+}
+void glDrawElementsBaseVertex(GLenum, GLsizei count, GLenum, const void*, GLint) { draw_(count); }
+
+#endif
@@ -0,0 +1,166 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// the part of gl (and glew) the engine uses, backed by a recorder instead of a driver.
+// only included through gfx/gl.h with ARC_NULL_GL.
+
+// glfw must not pull the system gl header over this one.
+#define GLFW_INCLUDE_NONE
+
+typedef unsigned int GLenum;
+typedef unsigned int GLuint;
+typedef int GLint;
+typedef int GLsizei;
+typedef unsigned char GLboolean;
+typedef unsigned int GLbitfield;
+typedef float GLfloat;
+typedef char GLchar;
+typedef std::ptrdiff_t GLsizeiptr;
+typedef std::ptrdiff_t GLintptr;
+typedef uint64_t GLuint64;
+typedef struct __GLsync* GLsync;
+typedef void (*GLDEBUGPROC)(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+                            const GLchar* message, const void* user);
+
+#define GLEW_OK 0
+// without buffer storage the stream ring takes the orphaning path, whose uploads are recorded.
+#define GLEW_ARB_buffer_storage false
+
+#define GL_FALSE 0
+#define GL_TRUE 1
+#define GL_NO_ERROR 0
+#define GL_POINTS 0x0000
+#define GL_LINES 0x0001
+#define GL_TRIANGLES 0x0004
+#define GL_TRIANGLE_STRIP 0x0005
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#define GL_MAP_WRITE_BIT 0x0002
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DEPTH_BUFFER_BIT 0x00000100
+#define GL_COLOR_BUFFER_BIT 0x00004000
+#define GL_ONE 1
+#define GL_SRC_ALPHA 0x0302
+#define GL_ONE_MINUS_SRC_ALPHA 0x0303
+#define GL_BLEND 0x0BE2
+#define GL_SCISSOR_TEST 0x0C11
+#define GL_UNPACK_ROW_LENGTH 0x0CF2
+#define GL_UNPACK_ALIGNMENT 0x0CF5
+#define GL_TEXTURE_2D 0x0DE1
+#define GL_DONT_CARE 0x1100
+#define GL_UNSIGNED_BYTE 0x1401
+#define GL_SHORT 0x1402
+#define GL_UNSIGNED_SHORT 0x1403
+#define GL_FLOAT 0x1406
+#define GL_HALF_FLOAT 0x140B
+#define GL_RED 0x1903
+#define GL_RGBA 0x1908
+#define GL_NEAREST 0x2600
+#define GL_LINEAR 0x2601
+#define GL_TEXTURE_MAG_FILTER 0x2800
+#define GL_TEXTURE_MIN_FILTER 0x2801
+#define GL_TEXTURE_WRAP_S 0x2802
+#define GL_TEXTURE_WRAP_T 0x2803
+#define GL_REPEAT 0x2901
+#define GL_CLAMP_TO_EDGE 0x812F
+#define GL_R8 0x8229
+#define GL_DEBUG_OUTPUT_SYNCHRONOUS 0x8242
+#define GL_MIRRORED_REPEAT 0x8370
+#define GL_TEXTURE0 0x84C0
+#define GL_ARRAY_BUFFER 0x8892
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#define GL_STREAM_DRAW 0x88E0
+#define GL_STATIC_DRAW 0x88E4
+#define GL_DYNAMIC_DRAW 0x88E8
+#define GL_FRAGMENT_SHADER 0x8B30
+#define GL_VERTEX_SHADER 0x8B31
+#define GL_COMPILE_STATUS 0x8B81
+#define GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#define GL_COLOR_ATTACHMENT0 0x8CE0
+#define GL_FRAMEBUFFER 0x8D40
+#define GL_TEXTURE_SWIZZLE_RGBA 0x8E46
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define GL_ALREADY_SIGNALED 0x911A
+#define GL_TIMEOUT_EXPIRED 0x911B
+#define GL_CONDITION_SATISFIED 0x911C
+#define GL_WAIT_FAILED 0x911D
+#define GL_DEBUG_OUTPUT 0x92E0
+
+GLenum glewInit();
+GLenum glGetError();
+
+void glEnable(GLenum cap);
+void glDisable(GLenum cap);
+void glBlendFunc(GLenum sfactor, GLenum dfactor);
+void glScissor(GLint x, GLint y, GLsizei width, GLsizei height);
+void glViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+void glClearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a);
+void glClear(GLbitfield mask);
+void glPixelStorei(GLenum pname, GLint param);
+void glDebugMessageCallback(GLDEBUGPROC callback, const void* user);
+void glDebugMessageControl(GLenum source, GLenum type, GLenum severity, GLsizei count, const GLuint* ids,
+                           GLboolean enabled);
+
+void glGenBuffers(GLsizei n, GLuint* buffers);
+void glDeleteBuffers(GLsizei n, const GLuint* buffers);
+void glBindBuffer(GLenum target, GLuint buffer);
+void glBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data);
+void glBufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+void* glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+GLboolean glUnmapBuffer(GLenum target);
+GLsync glFenceSync(GLenum condition, GLbitfield flags);
+GLenum glClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout);
+void glDeleteSync(GLsync sync);
+void glGenVertexArrays(GLsizei n, GLuint* arrays);
+void glDeleteVertexArrays(GLsizei n, const GLuint* arrays);
+void glBindVertexArray(GLuint array);
+void glEnableVertexAttribArray(GLuint index);
+void glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride,
+                           const void* pointer);
+void glVertexAttribDivisor(GLuint index, GLuint divisor);
+
+void glGenTextures(GLsizei n, GLuint* textures);
+void glDeleteTextures(GLsizei n, const GLuint* textures);
+void glActiveTexture(GLenum texture);
+void glBindTexture(GLenum target, GLuint texture);
+void glTexParameteri(GLenum target, GLenum pname, GLint param);
+void glTexParameteriv(GLenum target, GLenum pname, const GLint* params);
+void glTexImage2D(GLenum target, GLint level, GLint internal, GLsizei width, GLsizei height, GLint border,
+                  GLenum format, GLenum type, const void* pixels);
+void glTexSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format,
+                     GLenum type, const void* pixels);
+
+void glGenFramebuffers(GLsizei n, GLuint* framebuffers);
+void glDeleteFramebuffers(GLsizei n, const GLuint* framebuffers);
+void glBindFramebuffer(GLenum target, GLuint framebuffer);
+void glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level);
+GLenum glCheckFramebufferStatus(GLenum target);
+
+GLuint glCreateShader(GLenum type);
+void glDeleteShader(GLuint shader);
+void glShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length);
+void glCompileShader(GLuint shader);
+void glGetShaderiv(GLuint shader, GLenum pname, GLint* params);
+void glGetShaderInfoLog(GLuint shader, GLsizei size, GLsizei* length, GLchar* log);
+GLuint glCreateProgram();
+void glDeleteProgram(GLuint program);
+void glAttachShader(GLuint program, GLuint shader);
+void glDetachShader(GLuint program, GLuint shader);
+void glBindFragDataLocation(GLuint program, GLuint color, const GLchar* name);
+void glLinkProgram(GLuint program);
+void glValidateProgram(GLuint program);
+void glUseProgram(GLuint program);
+GLint glGetUniformLocation(GLuint program, const GLchar* name);
+GLint glGetAttribLocation(GLuint program, const GLchar* name);
+void glUniform1i(GLint location, GLint v0);
+void glUniform1f(GLint location, GLfloat v0);
+void glUniform2f(GLint location, GLfloat v0, GLfloat v1);
+void glUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2);
+void glUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3);
+void glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+
+void glDrawArrays(GLenum mode, GLint first, GLsizei count);
+void glDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances);
+void glDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* indices, GLint base);
@@ -0,0 +1,155 @@
+#include "gfx/glyph_atlas.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "core/log.h"
+#include "core/math.h"
+#include "core/time.h"
+#include "gfx/gl.h"
+
+namespace arc {
+
+bool glyph_page::try_place(int w, int h, int* ox, int* oy) {
+    int rw = w + ARC_GLYPH_PADDING;
+    int rh = h + ARC_GLYPH_PADDING;
+
+    // the lowest shelf that still has room, so tall shelves are kept for tall glyphs.
+    shelf* best = nullptr;
+    for (shelf& s : shelves)
+        if (s.height >= rh && s.x + rw <= size && (best == nullptr || s.height < best->height)) best = &s;
+
+    if (best == nullptr) {
+        if (shelf_top + rh > size || ARC_GLYPH_PADDING + rw > size) return false;
+        shelves.push_back({shelf_top, rh, ARC_GLYPH_PADDING});
+        shelf_top += rh;
+        best = &shelves.back();
+    }
+
+    *ox = best->x;
+    *oy = best->y;
+    best->x += rw;
+    return true;
+}
+
+void glyph_page::write(int x, int y, int w, int h, const uint8_t* src) {
+    for (int r = 0; r < h; r++) std::memcpy(pixels.data() + (y + r) * size + x, src + r * w, w);
+    dirty_x0 = std::min(dirty_x0, x);
+    dirty_y0 = std::min(dirty_y0, y);
+    dirty_x1 = std::max(dirty_x1, x + w);
+    dirty_y1 = std::max(dirty_y1, y + h);
+}
+
+void glyph_page::reset() {
+    std::fill(pixels.begin(), pixels.end(), 0);
+    shelves.clear();
+    shelf_top = ARC_GLYPH_PADDING;
+    glyphs.clear();
+    dirty_x0 = dirty_y0 = 0;
+    dirty_x1 = dirty_y1 = size;
+}
+
+void glyph_page::upload() {
+    if (dirty_x1 <= dirty_x0 || dirty_y1 <= dirty_y0) return;
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, tex->texture_id_);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, size);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, dirty_x0, dirty_y0, dirty_x1 - dirty_x0, dirty_y1 - dirty_y0, GL_RED,
+                    GL_UNSIGNED_BYTE, pixels.data() + dirty_y0 * size + dirty_x0);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    dirty_x0 = dirty_y0 = INT32_MAX;
+    dirty_x1 = dirty_y1 = 0;
+}
+
+static std::unique_ptr<glyph_page> make_page_(int size, texture_parameters params) {
+    auto pg = std::make_unique<glyph_page>();
+    pg->size = size;
+    pg->pixels.assign(static_cast<size_t>(size) * size, 0);
+    pg->tex = texture::make(nullptr);
+    pg->tex->full_width = pg->tex->width = size;
+    pg->tex->full_height = pg->tex->height = size;
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, pg->tex->texture_id_);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, size, size, 0, GL_RED, GL_UNSIGNED_BYTE, pg->pixels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    // sampled as white with the coverage in alpha, like the rgba glyphs were.
+    GLint swizzle[4] = {GL_ONE, GL_ONE, GL_ONE, GL_RED};
+    glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    pg->tex->parameters(params);
+    return pg;
+}
+
+std::shared_ptr<texture> glyph_atlas::place(char32_t ch, int w, int h, const uint8_t* src, int* page, bool evict) {
+    if (pages.empty()) pages.push_back(make_page_(page_size, params));
+
+    // nothing to draw, the padding corner is always blank.
+    if (w <= 0 || h <= 0) {
+        *page = 0;
+        return pages[0]->tex->cut(quad(0, 0, 0, 0));
+    }
+    if (w + ARC_GLYPH_PADDING * 2 > page_size || h + ARC_GLYPH_PADDING * 2 > page_size)
+        print_throw(log_level::fatal, "glyph {}x{} is larger than a glyph page.", w, h);
+
+    int x, y;
+    int i = 0;
+    for (; i < static_cast<int>(pages.size()); i++)
+        if (pages[i]->try_place(w, h, &x, &y)) break;
+
+    if (i == static_cast<int>(pages.size())) {
+        if (static_cast<int>(pages.size()) < page_limit) {
+            pages.push_back(make_page_(page_size, params));
+        } else {
+            if (!evict) return nullptr;
+
+            long tick = clock::now().render_ticks;
+            int lru = -1;
+            for (int j = 0; j < static_cast<int>(pages.size()); j++)
+                if (pages[j]->last_use != tick && (lru == -1 || pages[j]->last_use < pages[lru]->last_use)) lru = j;
+
+            if (lru == -1) {
+                // every page is on screen, going over the limit is better than drawing wrong glyphs.
+                print(log_level::warn, "glyph pages are all in use, opening page {}.", pages.size() + 1);
+                pages.push_back(make_page_(page_size, params));
+            } else {
+                // the page index is kept, so pages after it do not move.
+                if (on_evict) on_evict(pages[lru]->glyphs);
+                pages[lru]->reset();
+                i = lru;
+            }
+        }
+        pages[i]->try_place(w, h, &x, &y);
+    }
+
+    glyph_page& pg = *pages[i];
+    pg.write(x, y, w, h, src);
+    pg.glyphs.push_back(ch);
+    *page = i;
+    return pg.tex->cut(quad(x, y, w, h));
+}
+
+void glyph_atlas::touch(int page) {
+    if (page >= 0 && page < static_cast<int>(pages.size())) pages[page]->last_use = clock::now().render_ticks;
+}
+
+void glyph_atlas::upload() {
+    for (auto& pg : pages) pg->upload();
+}
+
+std::shared_ptr<glyph_atlas> glyph_atlas::make(int page_size, int page_limit, texture_parameters params) {
+    auto atl = std::make_shared<glyph_atlas>();
+    atl->page_size = page_size;
+    atl->page_limit = page_limit;
+    atl->params = params;
+    return atl;
+}
+
+}  // namespace arc
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "gfx/image.h"
+
+#define ARC_GLYPH_PAGE_SIZE 1024
+#define ARC_GLYPH_PAGE_LIMIT 4
+#define ARC_GLYPH_PADDING 1
+
+namespace arc {
+
+// a single-channel page, glyphs are packed in shelves of similar height.
+struct glyph_page {
+    struct shelf {
+        int y, height, x;
+    };
+
+    int size;
+    // r8, one byte per texel.
+    std::vector<uint8_t> pixels;
+    std::shared_ptr<texture> tex;
+    std::vector<shelf> shelves;
+    int shelf_top = ARC_GLYPH_PADDING;
+    // code points on the page, dropped together on eviction.
+    std::vector<char32_t> glyphs;
+    // the render tick this page was last drawn in.
+    long last_use = -1;
+    // texels [dirty_x0, dirty_x1) x [dirty_y0, dirty_y1) are not uploaded yet.
+    int dirty_x0 = INT32_MAX, dirty_y0 = INT32_MAX, dirty_x1 = 0, dirty_y1 = 0;
+
+    // find room for a w x h bitmap, return false when the page is full.
+    bool try_place(int w, int h, int* ox, int* oy);
+    void write(int x, int y, int w, int h, const uint8_t* src);
+    void reset();
+    void upload();
+};
+
+// pages of glyphs, the least recently drawn page is evicted when all of them are full.
+struct glyph_atlas {
+    std::vector<std::unique_ptr<glyph_page>> pages;
+    int page_size = ARC_GLYPH_PAGE_SIZE;
+    int page_limit = ARC_GLYPH_PAGE_LIMIT;
+    texture_parameters params;
+    // called with the code points of an evicted page, their textures are going to be overwritten.
+    std::function<void(const std::vector<char32_t>&)> on_evict;
+
+    // place a w x h single-channel bitmap and return its texture, #page is set to the page index.
+    // when #evict is false and no page has room, nullptr is returned.
+    std::shared_ptr<texture> place(char32_t ch, int w, int h, const uint8_t* src, int* page, bool evict = true);
+    // mark a page drawn in the current render tick, it is not evicted in this tick.
+    void touch(int page);
+    // upload the changed parts of all pages, once for each page.
+    void upload();
+
+    static std::shared_ptr<glyph_atlas> make(int page_size, int page_limit, texture_parameters params);
+};
+
+}  // namespace arc
@@ -2,11 +2,7 @@
 
 #include "core/io.h"
 #include "core/log.h"
-
-// clang-format off
-#include <gl/glew.h>
-#include <gl/gl.h>
-// clang-format on
+#include "gfx/gl.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
@@ -0,0 +1,71 @@
+#include "gfx/instance.h"
+
+#include "core/log.h"
+#include "gfx/brush.h"
+#include "gfx/gl.h"
+
+namespace arc {
+
+instance_batch::~instance_batch() {
+    glDeleteVertexArrays(1, &vao_);
+    glDeleteBuffers(1, &quad_vbo_);
+    glDeleteBuffers(1, &inst_vbo_);
+}
+
+void instance_batch::clear() {
+    instance_buf.clear();
+    instance_count = 0;
+}
+
+void instance_batch::draw(brush* brush, std::shared_ptr<program> prog, std::shared_ptr<texture> tex,
+                          const std::function<void(program* program)>& uniforms) {
+    if (instance_count <= 0) return;
+    // keep the order with what is already batched.
+    brush->flush();
+
+    glBindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, quad_vbo_);
+    prog->get_attrib(0).layout(shader_vertex_data_type::f32, 2, 8, 0);
+    prog->get_attrib(0).divisor(0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, inst_vbo_);
+    if (instance_buf.size() > inst_cap_) {
+        inst_cap_ = instance_buf.capacity();
+        glBufferData(GL_ARRAY_BUFFER, inst_cap_, instance_buf.data(), GL_STREAM_DRAW);
+    } else {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, instance_buf.size(), instance_buf.data());
+    }
+
+    glUseProgram(prog->program_id_);
+    if (prog->callback_setup != nullptr) prog->callback_setup(prog.get());
+    if (uniforms != nullptr) uniforms(prog.get());
+
+    if (prog->cached_uniforms.size() == 0)
+        print_throw(log_level::fatal, "please cache at lease a uniform u_proj.");
+    else
+        // instances are never transformed on cpu.
+        prog->cached_uniforms[0].set(brush->get_combined_transform());
+
+    if (tex != nullptr) tex->bind_(1);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, instance_count);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
+
+std::shared_ptr<instance_batch> instance_batch::make() {
+    std::shared_ptr<instance_batch> batch = std::make_shared<instance_batch>();
+    const float corners[8] = {0, 0, 1, 0, 0, 1, 1, 1};
+
+    glGenVertexArrays(1, &batch->vao_);
+    glGenBuffers(1, &batch->quad_vbo_);
+    glGenBuffers(1, &batch->inst_vbo_);
+    glBindBuffer(GL_ARRAY_BUFFER, batch->quad_vbo_);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return batch;
+}
+
+}  // namespace arc
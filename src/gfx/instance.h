@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "gfx/image.h"
+#include "gfx/shader.h"
+
+namespace arc {
+
+struct brush;
+
+// draws a unit quad many times with one call, each time with its own per-instance data.
+// the quad corners (0, 0) to (1, 1) are attribute 0, the program places them from the instance attributes.
+// the program's #callback_setup lays out the instance attributes (1 and on) with a divisor of 1.
+struct instance_batch {
+    std::vector<uint8_t> instance_buf;
+    int instance_count = 0;
+    /* unstable */ unsigned int vao_ = 0, quad_vbo_ = 0, inst_vbo_ = 0;
+    /* unstable */ size_t inst_cap_ = 0;
+
+    ~instance_batch();
+
+    // write an instance, T is the whole instance struct.
+    template <typename T>
+    instance_batch& push(const T& t) {
+        size_t old = instance_buf.size();
+        instance_buf.resize(old + sizeof(T));
+        std::memcpy(instance_buf.data() + old, &t, sizeof(T));
+        instance_count++;
+        return *this;
+    }
+
+    void clear();
+    // flush the brush, then draw every instance with the camera of the brush.
+    // #uniforms is called after the program is bound, the first cached uniform must be u_proj.
+    void draw(brush* brush, std::shared_ptr<program> prog, std::shared_ptr<texture> tex,
+              const std::function<void(program* program)>& uniforms = nullptr);
+
+    static std::shared_ptr<instance_batch> make();
+};
+
+}  // namespace arc
@@ -2,11 +2,7 @@
 
 #include "gfx/brush.h"
 #include "gfx/buffer.h"
-
-// clang-format off
-#include <gl/glew.h>
-#include <gl/gl.h>
-// clang-format on
+#include "gfx/gl.h"
 
 namespace arc {
 
@@ -19,7 +15,6 @@ mesh::mesh() {
 mesh::~mesh() {
     glDeleteVertexArrays(1, &vao_);
     glDeleteBuffers(1, &vbo_);
-    glDeleteBuffers(1, &ebo_);
 }
 
 brush* mesh::retry() {
@@ -42,9 +37,13 @@ void mesh::draw(brush* gbrush) {
     gbrush->wbuf = buffer.get();
     gbrush->mesh_root_ = this;
     gbrush->clear_when_flush_ = false;
+    // mesh vertices are local, the transform at draw time goes to the uniform.
+    bool old_cpu = gbrush->cpu_transform_;
+    gbrush->cpu_transform_ = false;
 
     gbrush->flush();
 
+    gbrush->cpu_transform_ = old_cpu;
     gbrush->clear_when_flush_ = true;
     gbrush->mesh_root_ = old_msh;
     gbrush->wbuf = old_buf;
@@ -55,13 +54,11 @@ std::shared_ptr<mesh> mesh::make() {
     std::shared_ptr<mesh> msh = std::make_shared<mesh>();
     std::shared_ptr<complex_buffer> buf = msh->buffer;
 
-    unsigned int vao, vbo, ebo;
+    unsigned int vao, vbo;
     glGenVertexArrays(1, &vao);
     glGenBuffers(1, &vbo);
-    glGenBuffers(1, &ebo);
     msh->vao_ = vao;
     msh->vbo_ = vbo;
-    msh->ebo_ = ebo;
 
     return msh;
 }
@@ -11,8 +11,8 @@ struct mesh {
     std::shared_ptr<complex_buffer> buffer;
     std::unique_ptr<brush> brush_;
 
-    /* unstable */ unsigned int vao_, vbo_, ebo_;
-    /* unstable */ bool is_direct_;
+    /* unstable */ unsigned int vao_, vbo_;
+    /* unstable */ bool is_direct_ = false;
 
     mesh();
     ~mesh();
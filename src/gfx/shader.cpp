@@ -3,11 +3,8 @@
 #include "core/log.h"
 #include "core/math.h"
 #include "gfx/color.h"
-
-// clang-format off
-#include <gl/glew.h>
-#include <gl/gl.h>
-// clang-format on
+#include "gfx/gl.h"
+#include "gfx/state.h"
 
 namespace arc {
 
@@ -20,6 +17,12 @@ void shader_attrib::layout(shader_vertex_data_type size, int components, int str
         case shader_vertex_data_type::u8:
             type = GL_UNSIGNED_BYTE;
             break;
+        case shader_vertex_data_type::i16:
+            type = GL_SHORT;
+            break;
+        case shader_vertex_data_type::u16:
+            type = GL_UNSIGNED_SHORT;
+            break;
         case shader_vertex_data_type::i32:
             type = GL_UNSIGNED_SHORT;
             break;
@@ -36,6 +39,8 @@ void shader_attrib::layout(shader_vertex_data_type size, int components, int str
     glVertexAttribPointer(attrib_id_, components, type, normalize, stride, reinterpret_cast<void*>(offset));
 }
 
+void shader_attrib::divisor(int d) { glVertexAttribDivisor(attrib_id_, d); }
+
 shader_uniform::shader_uniform(unsigned int id) : uniform_id_(id) {}
 
 void shader_uniform::set_texture_unit(int unit) { glUniform1i(uniform_id_, unit); }
@@ -135,6 +140,22 @@ static const std::string dfrag_textured_ =
     "    fragColor = o_color * texture(u_tex, o_texCoord);\n"
     "}";
 
+static const std::string dvert_compact_ =
+    std::string("#version 330 core\n"
+                "layout(location = 0) in vec2 i_position;\n"
+                "layout(location = 1) in vec4 i_color;\n"
+                "layout(location = 2) in vec2 i_texCoord;\n"
+                "out vec4 o_color;\n"
+                "out vec2 o_texCoord;\n"
+                "uniform mat4 u_proj;\n"
+                "void main() {\n"
+                "    o_color = i_color;\n"
+                "    o_texCoord = i_texCoord / ") +
+    std::to_string(ARC_COMPACT_UV_SCALE) +
+    ".0;\n"
+    "    gl_Position = u_proj * vec4(i_position.x, i_position.y, 0.0, 1.0);\n"
+    "}";
+
 static const std::string dvert_colored_ =
     "#version 330 core\n"
     "layout(location = 0) in vec2 i_position;\n"
@@ -154,10 +175,11 @@ static const std::string dfrag_colored_ =
     "    fragColor = o_color;\n"
     "}";
 
-static std::shared_ptr<program> builtin_colored_ = nullptr, builtin_textured_ = nullptr;
+static std::shared_ptr<program> builtin_colored_ = nullptr, builtin_textured_ = nullptr, builtin_compact_ = nullptr;
+static std::shared_ptr<program> builtin_textured_ldr_ = nullptr, builtin_colored_ldr_ = nullptr;
 
 std::shared_ptr<program> program::make(builtin_program_type type) {
-    if (builtin_colored_ == nullptr || builtin_textured_ == nullptr) {
+    if (builtin_colored_ == nullptr) {
         builtin_colored_ = program::make(dvert_colored_, dfrag_colored_, [](program* program) {
             program->get_attrib(0).layout(shader_vertex_data_type::f32, 2, 16, 0);
             program->get_attrib(1).layout(shader_vertex_data_type::f16, 4, 16, 8);
@@ -174,12 +196,44 @@ std::shared_ptr<program> program::make(builtin_program_type type) {
             program->cache_uniform("u_proj");                     // 0
             program->cache_uniform("u_tex").set_texture_unit(1);  // 1
         });
+        // the brush folds the origin and the position scale into u_proj.
+        builtin_compact_ = program::make(dvert_compact_, dfrag_textured_, [](program* program) {
+            program->get_attrib(0).layout(shader_vertex_data_type::i16, 2, 12, 0);
+            program->get_attrib(1).layout(shader_vertex_data_type::u8, 4, 12, 4, true);
+            program->get_attrib(2).layout(shader_vertex_data_type::u16, 2, 12, 8);
+
+            if (program->cached_uniforms.size() > 0) return;
+            program->cache_uniform("u_proj");                     // 0
+            program->cache_uniform("u_tex").set_texture_unit(1);  // 1
+        });
+        builtin_textured_ldr_ = program::make(dvert_textured_, dfrag_textured_, [](program* program) {
+            program->get_attrib(0).layout(shader_vertex_data_type::f32, 2, 20, 0);
+            program->get_attrib(1).layout(shader_vertex_data_type::u8, 4, 20, 8, true);
+            program->get_attrib(2).layout(shader_vertex_data_type::f32, 2, 20, 12);
+
+            if (program->cached_uniforms.size() > 0) return;
+            program->cache_uniform("u_proj");                     // 0
+            program->cache_uniform("u_tex").set_texture_unit(1);  // 1
+        });
+        builtin_colored_ldr_ = program::make(dvert_colored_, dfrag_colored_, [](program* program) {
+            program->get_attrib(0).layout(shader_vertex_data_type::f32, 2, 12, 0);
+            program->get_attrib(1).layout(shader_vertex_data_type::u8, 4, 12, 8, true);
+
+            if (program->cached_uniforms.size() > 0) return;
+            program->cache_uniform("u_proj");  // 0
+        });
     }
     switch (type) {
         case builtin_program_type::colored:
             return builtin_colored_;
         case builtin_program_type::textured:
             return builtin_textured_;
+        case builtin_program_type::textured_compact:
+            return builtin_compact_;
+        case builtin_program_type::textured_ldr:
+            return builtin_textured_ldr_;
+        case builtin_program_type::colored_ldr:
+            return builtin_colored_ldr_;
     }
     return nullptr;
 }
@@ -6,7 +6,7 @@
 
 namespace arc {
 
-enum class shader_vertex_data_type { u8, i32, f16, f32 };
+enum class shader_vertex_data_type { u8, i16, u16, i32, f16, f32 };
 
 struct shader_attrib {
     unsigned int attrib_id_ = 0;
@@ -14,6 +14,8 @@ struct shader_attrib {
     shader_attrib(unsigned int id);
 
     void layout(shader_vertex_data_type size, int components, int stride, int offset, bool normalize = false);
+    // advance the attribute once per #d instances instead of once per vertex. 0 restores per vertex.
+    void divisor(int d);
 };
 
 struct shader_uniform {
@@ -32,7 +34,7 @@ struct shader_uniform {
     void set(const transform& v);
 };
 
-enum class builtin_program_type { textured, colored };
+enum class builtin_program_type { textured, colored, textured_compact, textured_ldr, colored_ldr };
 
 struct program {
     /* unstable */ unsigned int program_id_ = 0;
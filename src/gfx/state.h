@@ -2,6 +2,12 @@
 #include "gfx/image.h"
 #include "gfx/shader.h"
 
+// compact positions are in 1/ARC_COMPACT_POS_SCALE units from the origin, int16 covers +-128 units.
+#define ARC_COMPACT_POS_SCALE 256
+// compact uvs are in 1/ARC_COMPACT_UV_SCALE units, uint16 covers 32 repeats of a texture (greedy runs repeat it).
+// exact for power of two textures up to that size.
+#define ARC_COMPACT_UV_SCALE 2048
+
 namespace arc {
 
 enum class graph_mode { colored_point, colored_line, colored_triangle, colored_quad, textured_quad };
@@ -14,11 +20,19 @@ struct brush_flag {
 
 enum class blend_mode { normal, add };
 
+// how the brush lays out vertices. compact is for static textured meshes, see vertex_compact. ldr keeps the standard
+// layout with unorm8 colours clamped to [0, 1], for what does not need hdr. the builtin programs read all of them,
+// a custom program is expected to read the standard one.
+enum class vertex_format { standard, compact, ldr };
+
 struct graph_state {
     graph_mode mode = graph_mode::textured_quad;
     std::shared_ptr<texture> texture = nullptr;
     std::shared_ptr<program> prog = nullptr;
     std::function<void(program* program)> callback_uniform;
+    vertex_format format = vertex_format::standard;
+    // compact positions are relative to this point.
+    vec2 origin;
 };
 
 }  // namespace arc
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include "gfx/stream.h"
+
+#include <cstring>
+
+#include "core/log.h"
+#include "gfx/gl.h"
+
+namespace arc {
+
+stream_ring::~stream_ring() { release_(); }
+
+void stream_ring::release_() {
+    for (auto& f : fences_) {
+        if (f != nullptr) glDeleteSync(static_cast<GLsync>(f));
+        f = nullptr;
+    }
+    if (vbo_ != 0) {
+        if (mapped_ != nullptr) {
+            glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+        }
+        glDeleteBuffers(1, &vbo_);
+    }
+    vbo_ = 0;
+    mapped_ = nullptr;
+}
+
+void stream_ring::allocate_(size_t sec_bytes) {
+    release_();
+    section_bytes = sec_bytes;
+    section = 0;
+    head = 0;
+
+    size_t size = section_bytes * ARC_STREAM_SECTIONS;
+    glGenBuffers(1, &vbo_);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+
+    persistent_ = GLEW_ARB_buffer_storage;
+    if (persistent_) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+        mapped_ = static_cast<uint8_t*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+        if (mapped_ == nullptr) {
+            // storage is immutable, a fresh buffer is needed for the fallback.
+            print(log_level::warn, "stream ring cannot be mapped, orphaning instead.");
+            glDeleteBuffers(1, &vbo_);
+            glGenBuffers(1, &vbo_);
+            glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+            persistent_ = false;
+        }
+    }
+    if (!persistent_) glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+}
+
+int stream_ring::write(const void* data, size_t bytes, int stride) {
+    if (bytes > section_bytes) {
+        size_t sec = section_bytes == 0 ? ARC_STREAM_SECTION_BYTES : section_bytes;
+        while (sec < bytes) sec *= 2;
+        allocate_(sec);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+
+    // a base vertex counts whole vertices.
+    size_t at = (head + stride - 1) / stride * stride;
+    size_t sec_end = (section + 1) * section_bytes;
+
+    if (at + bytes > sec_end) {
+        // fence what the gpu still reads of this section and move on to the next one.
+        int next = (section + 1) % ARC_STREAM_SECTIONS;
+        if (persistent_) {
+            if (fences_[section] != nullptr) glDeleteSync(static_cast<GLsync>(fences_[section]));
+            fences_[section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            if (fences_[next] != nullptr) {
+                // only waits when the gpu is a whole ring behind.
+                GLsync fence = static_cast<GLsync>(fences_[next]);
+                GLenum r = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000'000);
+                if (r == GL_TIMEOUT_EXPIRED || r == GL_WAIT_FAILED)
+                    print(log_level::warn, "stream ring waited too long for section {}.", next);
+                glDeleteSync(fence);
+                fences_[next] = nullptr;
+            }
+        } else if (next == 0) {
+            // the driver hands out new storage, the old one lives until the gpu is done.
+            glBufferData(GL_ARRAY_BUFFER, section_bytes * ARC_STREAM_SECTIONS, nullptr, GL_STREAM_DRAW);
+        }
+        section = next;
+        at = section * section_bytes;
+        at = (at + stride - 1) / stride * stride;
+        // alignment may push a section-sized write over the end, give it a clean start.
+        if (at + bytes > (section + 1) * section_bytes) {
+            allocate_(section_bytes * 2);
+            glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+            at = 0;
+        }
+    }
+
+    if (persistent_)
+        std::memcpy(mapped_ + at, data, bytes);
+    else
+        glBufferSubData(GL_ARRAY_BUFFER, at, bytes, data);
+    head = at + bytes;
+    return static_cast<int>(at / stride);
+}
+
+stream_ring& stream_ring::direct() {
+    static stream_ring ring;
+    return ring;
+}
+
+}  // namespace arc
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// sections of the streaming ring, the gpu may read two while the third is written.
+#define ARC_STREAM_SECTIONS 3
+// bytes of a section at first, it grows when one flush does not fit.
+#define ARC_STREAM_SECTION_BYTES (1 << 20)
+
+namespace arc {
+
+// one vertex buffer that immediate draws are streamed through, instead of re-specifying a buffer every flush.
+// with buffer storage it is mapped once and fenced per section, otherwise it is orphaned when it wraps.
+struct stream_ring {
+    /* unstable */ unsigned int vbo_ = 0;
+    /* unstable */ uint8_t* mapped_ = nullptr;
+    /* unstable */ bool persistent_ = false;
+    size_t section_bytes = 0;
+    int section = 0;
+    // write offset inside the whole buffer.
+    size_t head = 0;
+    /* unstable */ void* fences_[ARC_STREAM_SECTIONS] = {};
+
+    ~stream_ring();
+
+    // copy the vertices in and leave the ring bound to GL_ARRAY_BUFFER.
+    // returns the offset of the first vertex in vertices of #stride bytes, for a base vertex.
+    int write(const void* data, size_t bytes, int stride);
+    void allocate_(size_t sec_bytes);
+    void release_();
+
+    // the ring the direct meshes share.
+    static stream_ring& direct();
+};
+
+}  // namespace arc
@@ -44,6 +44,9 @@ void lua_bind_gfx(lua_state& lua) {
     brush_type["ts_load"] = &brush::ts_load;
     brush_type["clear"] = &brush::clear;
     brush_type["flush"] = &brush::flush;
+    brush_type["cq_begin"] = &brush::cq_begin;
+    brush_type["cq_layer"] = &brush::cq_layer;
+    brush_type["cq_end"] = &brush::cq_end;
     brush_type["use_camera"] = &brush::use_camera;
     brush_type["use_program"] = &brush::use_program;
     brush_type["use_state"] = &brush::use_state;
@@ -11,6 +11,7 @@
 #include "core/rand.h"
 #include "ctt.h"
 #include "gfx/atlas.h"
+#include "gfx/bench.h"
 #include "gfx/brush.h"
 #include "gfx/camera.h"
 #include "gfx/device.h"
@@ -61,11 +62,13 @@ struct posic {
 };
 
 int main() {
+#ifndef ARC_NULL_GL
     tk_make_handle();
     tk_title("arcvia test");
     tk_size(vec2(800, 450));
     tk_icon(image::load(path::open_local("gfx/misc/logo.png")));
     tk_end_make_handle();
+#endif
 
     R_make_nonnulls();
     atl = atlas::make(1024, 1024);
@@ -75,6 +78,7 @@ int main() {
     auto DIRT_MODEL = R_block_models().make(
         "arc:dirt", block_model{.dropper = block_dropper::repeat,
                                 .dynamic_render = false,
+                                .greedy_mesh = true,
                                 .tex = atl->accept(image::load(path::open_local("gfx/dirt.png")))});
     auto DIRT = R_blocks().make("arc:dirt", beh);
     DIRT->model = DIRT_MODEL;
@@ -83,6 +87,7 @@ int main() {
     auto ROCK_MODEL = R_block_models().make(
         "arc:rock", block_model{.dropper = block_dropper::repeat,
                                 .dynamic_render = false,
+                                .greedy_mesh = true,
                                 .tex = atl->accept(image::load(path::open_local("gfx/rock.png")))});
     auto ROCK = R_blocks().make("arc:rock", beh);
     ROCK->model = ROCK_MODEL;
@@ -168,11 +173,12 @@ int main() {
     g->join(tv);
 
     g->display();
-    std::shared_ptr<entity> e_0 = std::make_shared<entity>();
+    std::shared_ptr<entity> e_0 = dim->arena.make();
     e_0->box = quad::center(2.5, 0, 1.75, 2.75);
     e_0->mass = 60;
     e_0->cat = entity_cat::creature;
     dim->spawn_entity(e_0);
+    dim->players.push_back(e_0->handle);
 
     uint16_t port = gen_tcp_port_();
     socks.start(port);
@@ -187,7 +193,7 @@ int main() {
         bool b = random::rg->next_bool();
         dim->set_block(b ? DIRT : ROCK, {2, 2});
         dim->tick();
-        dim->light_executor->tick(quad::center(10, 10, 60, 45));
+        dim->light_executor->tick(quad::center(10, 10, 60, 45), wrd::last_view().nb);
 
         const double vi = 20.0;
         if (key_held(ARC_KEY_D)) e_0->move({vi * clock::now().delta, 0}, {3, 0}, physic_ignore::land_f);
@@ -208,6 +214,16 @@ int main() {
             dim->set_liquid_stack({LAVA, liquid_stack::max_amount}, {curs.x, curs.y});
         else if (key_held(ARC_MOUSE_BUTTON_RIGHT))
             dim->set_block(ROCK, {curs.x, curs.y});
+
+        if (key_press(ARC_KEY_F9)) {
+            bench_brush_quads();
+            bench_color_packing();
+            bench_render_frames([&](brush* brush, int) {
+                brush->use_camera(camera::world({10, 10}, 60));
+                wrd::replay(brush, dim);
+            });
+            print(log_level::info, "light mesh build: {:.3f} ms.", dim->light_executor->mesh_build_seconds * 1000.0);
+        }
     };
 
     event_render += [&](brush* brush) {
@@ -223,7 +239,6 @@ int main() {
         // lua_protected_call(lua_get<lua_function>("draw"), brush);
 
         brush->use_camera(camera::world({10, 10}, 60));
-        reflush_chunk_models_(dim, {0, 0});
 
         wrd::retry();
         wrd::render(brush, dim, brush->camera_.view);
@@ -231,6 +246,17 @@ int main() {
         brush->draw_rect_outline({0, 0, 1, 1});
     };
 
+#ifdef ARC_NULL_GL
+    // no window and no audio, the demo scene is ticked and drawn once a frame as the script.
+    bench_render_frames(
+        [](brush* brush, int) {
+            event_tick();
+            event_render(brush);
+            // this stands in for the device loop, so it advances the render clock as the device does.
+            clock::now().render_ticks++;
+        },
+        600);
+#else
     tk_make_device();
     tk_set_device_option(device_option::roll_off, 2.0);
     tk_set_device_option(device_option::ref_dist, 8.0);
@@ -239,6 +265,7 @@ int main() {
     tk_end_make_device();
 
     tk_lifecycle(0, 20, false);
+#endif
 
     sockc.disconnect();
     socks.stop();
@@ -2,10 +2,14 @@
 
 #include <memory>
 
+#include "core/def.h"
+#include "core/time.h"
 #include "ctt.h"
 #include "gfx/brush.h"
+#include "gfx/shader.h"
 #include "render/chunk_model.h"
 #include "world/block.h"
+#include "world/chunknb.h"
 
 namespace arc {
 
@@ -18,6 +22,12 @@ constexpr static bool iscnnt_(block_behavior* r1, block_behavior* r2) { return r
 
 inline static std::shared_ptr<texture> get_block_ico_(block_behavior* r) { return R_block_models()[r->loc]->tex; }
 
+// how many cells the repeated texture covers before it starts over.
+inline static int repeat_period_(const std::shared_ptr<texture>& tex) { return tex->height / BP; }
+
+// the index of cell #c in a repeat of #p cells, counting up on both sides of 0.
+inline static int repeat_index_(int c, int p) { return (c % p + p) % p; }
+
 constexpr static long place_hash(int x, int y) {
     long hash = (long)x * 374761393 + (long)y * 668265263;
     hash = (hash ^ (hash >> 15)) * 2246822519;
@@ -32,8 +42,8 @@ void block_model::default_make_item_(brush* brush, block_model* self, dimension*
     brush->draw_texture(tex, quad(68, 16, 16, 16));
 }
 
-void block_model::default_make_block_(brush* brush, block_model* self, dimension* dim, block_behavior* block,
-                                      const pos2d& pos) {
+void block_model::default_make_block_(brush* brush, block_model* self, dimension* dim, const chunk_neighborhood& nb,
+                                      block_behavior* block, const pos2d& pos) {
     block_dropper dropper = self->dropper;
     std::shared_ptr<texture> tex = get_block_ico_(block);
 
@@ -47,8 +57,10 @@ void block_model::default_make_block_(brush* brush, block_model* self, dimension
     if (dropper == block_dropper::single) {
         brush->draw_texture(tex, place);
     } else if (dropper == block_dropper::repeat) {
-        double u = std::abs(x) % (tex->height / BP) * BP;
-        double v = std::abs(y) % (tex->height / BP) * BP;
+        // v is drawn at the top edge (y + 1) of the cell, so the rows count up as y goes down.
+        // a merged run (#default_make_block_area_) reads the same rows.
+        double u = repeat_index_(x, repeat_period_(tex)) * BP;
+        double v = repeat_index_(-y - 1, repeat_period_(tex)) * BP;
         quad area = quad(u, v, BP_D, BP_D);
         brush->draw_texture(tex, place, area);
     } else if (dropper == block_dropper::random) {
@@ -60,8 +72,116 @@ void block_model::default_make_block_(brush* brush, block_model* self, dimension
     }
 }
 
+void block_model::default_make_block_area_(brush* brush, block_model* self, dimension* dim,
+                                           const chunk_neighborhood& nb, block_behavior* block, const pos2i& pos,
+                                           const pos2i& size) {
+    std::shared_ptr<texture> tex = get_block_ico_(block);
+    int period = repeat_period_(tex);
+
+    quad place = quad(pos.x, pos.y, size.x, size.y);
+    place.inflate(OLN4, OLN4);
+
+    // starts at the row of the top cell (pos.y + size.y - 1), see #default_make_block_.
+    double u = repeat_index_(pos.x, period) * BP;
+    double v = repeat_index_(-pos.y - size.y, period) * BP;
+    brush->draw_texture(tex, place, quad(u, v, BP_D * size.x, BP_D * size.y));
+}
+
+static const std::string dvert_instance_ =
+    "#version 330 core\n"
+    "layout(location = 0) in vec2 i_corner;\n"
+    "layout(location = 1) in vec2 i_pos;\n"
+    "layout(location = 2) in float i_frame;\n"
+    "layout(location = 3) in vec4 i_tint;\n"
+    "out vec4 o_color;\n"
+    "out vec2 o_texCoord;\n"
+    "uniform mat4 u_proj;\n"
+    "uniform vec4 u_uv;\n"
+    "uniform vec2 u_grid;\n"
+    "void main() {\n"
+    "    float f = mod(floor(i_frame + 0.5), u_grid.x * u_grid.y);\n"
+    "    vec2 cell = vec2(mod(f, u_grid.x), floor(f / u_grid.x));\n"
+#ifdef ARC_Y_IS_DOWN
+    "    vec2 c = vec2(i_corner.x, 1.0 - i_corner.y);\n"
+#else
+    "    vec2 c = i_corner;\n"
+#endif
+    "    o_color = i_tint;\n"
+    "    o_texCoord = u_uv.xy + (cell + c) * u_uv.zw;\n"
+    "    vec2 p = i_pos + i_corner * 1.008 - 0.004;\n"
+    "    gl_Position = u_proj * vec4(p.x, p.y, 0.0, 1.0);\n"
+    "}";
+
+static const std::string dfrag_instance_ =
+    "#version 330 core\n"
+    "in vec4 o_color;\n"
+    "in vec2 o_texCoord;\n"
+    "out vec4 fragColor;\n"
+    "uniform sampler2D u_tex;\n"
+    "void main() {\n"
+    "    fragColor = o_color * texture(u_tex, o_texCoord);\n"
+    "}";
+
+static std::shared_ptr<program> instance_prog_;
+
+std::shared_ptr<program> block_model::instance_program_() {
+    if (instance_prog_ == nullptr) {
+        instance_prog_ = program::make(dvert_instance_, dfrag_instance_, [](program* program) {
+            const int s = sizeof(block_instance);
+            program->get_attrib(1).layout(shader_vertex_data_type::f32, 2, s, 0);
+            program->get_attrib(2).layout(shader_vertex_data_type::f32, 1, s, 8);
+            program->get_attrib(3).layout(shader_vertex_data_type::u8, 4, s, 12, true);
+            program->get_attrib(1).divisor(1);
+            program->get_attrib(2).divisor(1);
+            program->get_attrib(3).divisor(1);
+
+            if (program->cached_uniforms.size() > 0) return;
+            program->cache_uniform("u_proj");                     // 0
+            program->cache_uniform("u_tex").set_texture_unit(1);  // 1
+            program->cache_uniform("u_uv");                       // 2
+            program->cache_uniform("u_grid");                     // 3
+        });
+    }
+    return instance_prog_;
+}
+
+void block_model::set_instance_uniforms_(block_model* self, program* program) {
+    std::shared_ptr<texture> tex = self->tex;
+    double fw = tex->full_width;
+    double fh = tex->full_height;
+    color uv = color(tex->u / fw, tex->v / fh, BP_D / fw, BP_D / fh);
+    program->cached_uniforms[2].set(uv);
+    program->cached_uniforms[3].set(vec2(std::max(1, tex->width / BP), std::max(1, tex->height / BP)));
+}
+
+void block_model::default_make_instance_(block_model* self, dimension* dim, block_behavior* block, const pos2i& pos,
+                                         block_instance& out) {
+    out.x = pos.x;
+    out.y = pos.y;
+    out.frame = std::floor(clock::now().seconds * self->anim_fps);
+}
+
+bool block_model::can_greedy_(block_behavior* block) {
+    block_model* model = block->model;
+    return model->greedy_mesh && model->dropper == block_dropper::repeat && !model->dynamic_render &&
+           !block->render_place;
+}
+
+bool block_model::greedy_joinable_(block_behavior* block, int c0) {
+    std::shared_ptr<texture> tex = get_block_ico_(block);
+    int period = repeat_period_(tex);
+    int i0 = repeat_index_(c0, period);
+    int i1 = repeat_index_(c0 + 1, period);
+    // along y the rows run the other way, but the wrap still falls between the same two cells.
+    if (i1 == i0 + 1) return true;
+    // a standalone square texture wraps with uv_repeat, so the run may go across the period.
+    // a texture cut from an atlas would bleed into its neighbours instead.
+    return i0 == period - 1 && i1 == 0 && tex->root == nullptr && tex->width == tex->height;
+}
+
 template <int Binding_option_>
-void raw_make_border_(brush* brush, block_model* self, dimension* dim, block_behavior* block, const pos2d& pos) {
+void raw_make_border_(brush* brush, block_model* self, dimension* dim, const chunk_neighborhood& nb,
+                      block_behavior* block, const pos2d& pos) {
     const bool RANDOM_BORDER = true;
 
     if (!block->shape.solid) return;
@@ -80,23 +200,23 @@ void raw_make_border_(brush* brush, block_model* self, dimension* dim, block_beh
     block_behavior* rdb;
 
     if constexpr (Binding_option_ == 0) {
-        ub = fast_get_block(x, y - 1);
-        db = fast_get_block(x, y + 1);
-        lb = fast_get_block(x - 1, y);
-        rb = fast_get_block(x + 1, y);
-        lub = fast_get_block(x - 1, y - 1);
-        ldb = fast_get_block(x - 1, y + 1);
-        rub = fast_get_block(x + 1, y - 1);
-        rdb = fast_get_block(x + 1, y + 1);
+        ub = nb.find_block(x, y - 1);
+        db = nb.find_block(x, y + 1);
+        lb = nb.find_block(x - 1, y);
+        rb = nb.find_block(x + 1, y);
+        lub = nb.find_block(x - 1, y - 1);
+        ldb = nb.find_block(x - 1, y + 1);
+        rub = nb.find_block(x + 1, y - 1);
+        rdb = nb.find_block(x + 1, y + 1);
     } else if constexpr (Binding_option_ == 1) {
-        ub = fast_get_back_block(x, y - 1);
-        db = fast_get_back_block(x, y + 1);
-        lb = fast_get_back_block(x - 1, y);
-        rb = fast_get_back_block(x + 1, y);
-        lub = fast_get_back_block(x - 1, y - 1);
-        ldb = fast_get_back_block(x - 1, y + 1);
-        rub = fast_get_back_block(x + 1, y - 1);
-        rdb = fast_get_back_block(x + 1, y + 1);
+        ub = nb.find_back_block(x, y - 1);
+        db = nb.find_back_block(x, y + 1);
+        lb = nb.find_back_block(x - 1, y);
+        rb = nb.find_back_block(x + 1, y);
+        lub = nb.find_back_block(x - 1, y - 1);
+        ldb = nb.find_back_block(x - 1, y + 1);
+        rub = nb.find_back_block(x + 1, y - 1);
+        rdb = nb.find_back_block(x + 1, y + 1);
     }
 
     bool up = iscnnt_(ub, block);
@@ -156,14 +276,14 @@ void raw_make_border_(brush* brush, block_model* self, dimension* dim, block_beh
     }
 }
 
-void block_model::default_make_border_(brush* brush, block_model* self, dimension* dim, block_behavior* block,
-                                       const pos2d& pos) {
-    raw_make_border_<0>(brush, self, dim, block, pos);
+void block_model::default_make_border_(brush* brush, block_model* self, dimension* dim, const chunk_neighborhood& nb,
+                                       block_behavior* block, const pos2d& pos) {
+    raw_make_border_<0>(brush, self, dim, nb, block, pos);
 }
 
-void block_model::default_make_border_back_(brush* brush, block_model* self, dimension* dim, block_behavior* block,
-                                       const pos2d& pos) {
-    raw_make_border_<1>(brush, self, dim, block, pos);
+void block_model::default_make_border_back_(brush* brush, block_model* self, dimension* dim,
+                                            const chunk_neighborhood& nb, block_behavior* block, const pos2d& pos) {
+    raw_make_border_<1>(brush, self, dim, nb, block, pos);
 }
 
 }  // namespace arc
\ No newline at end of file
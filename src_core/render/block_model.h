@@ -8,30 +8,69 @@
 
 namespace arc {
 
+struct chunk_neighborhood;
+
 enum class block_dropper : uint8_t { single, repeat, random };
 
+// per-instance data of an instanced dynamic block.
+struct block_instance {
+    float x = 0;
+    float y = 0;
+    // index of a BP-sized cell of the model texture, counted row by row.
+    float frame = 0;
+    // rgba8, 0xFFFFFFFF is untinted.
+    uint32_t tint = 0xFFFFFFFF;
+};
+
 struct block_model {
     ARC_REGISTERABLE
     void (*make_item)(brush* brush, block_model* self, dimension* dim, block_behavior* block,
                       const pos2d& pos) = default_make_item_;
-    void (*make_block)(brush* brush, block_model* self, dimension* dim, block_behavior* block,
-                       const pos2d& pos) = default_make_block_;
-    void (*make_border)(brush* brush, block_model* self, dimension* dim, block_behavior* block,
-                        const pos2d& pos) = default_make_border_;
-    void (*make_border_back)(brush* brush, block_model* self, dimension* dim, block_behavior* block,
-                        const pos2d& pos) = default_make_border_back_;
+    void (*make_block)(brush* brush, block_model* self, dimension* dim, const chunk_neighborhood& nb,
+                       block_behavior* block, const pos2d& pos) = default_make_block_;
+    void (*make_border)(brush* brush, block_model* self, dimension* dim, const chunk_neighborhood& nb,
+                        block_behavior* block, const pos2d& pos) = default_make_border_;
+    void (*make_border_back)(brush* brush, block_model* self, dimension* dim, const chunk_neighborhood& nb,
+                             block_behavior* block, const pos2d& pos) = default_make_border_back_;
+    // draw a merged area of the same block, used by greedy meshing.
+    void (*make_block_area)(brush* brush, block_model* self, dimension* dim, const chunk_neighborhood& nb,
+                            block_behavior* block, const pos2i& pos, const pos2i& size) = default_make_block_area_;
+    // fill the instance of a dynamic block. when set, the dynamic blocks of this model skip #make_block and are
+    // drawn instanced, one call per model and chunk layer. the instance is filled again every frame.
+    void (*make_instance)(block_model* self, dimension* dim, block_behavior* block, const pos2i& pos,
+                          block_instance& out) = nullptr;
     block_dropper dropper = block_dropper::single;
     bool dynamic_render = false;
+    // merge runs of this block into larger quads in static chunk meshes.
+    // only takes effect with block_dropper::repeat, since the uvs have no per-cell variation.
+    bool greedy_mesh = false;
+    // frames per second used by #default_make_instance_.
+    double anim_fps = 8.0;
     std::shared_ptr<texture> tex = nullptr;
 
     static void default_make_item_(brush* brush, block_model* self, dimension* dim, block_behavior* block,
                                    const pos2d& pos);
-    static void default_make_block_(brush* brush, block_model* self, dimension* dim, block_behavior* block,
-                                    const pos2d& pos);
-    static void default_make_border_(brush* brush, block_model* self, dimension* dim, block_behavior* block,
-                                     const pos2d& pos);
-    static void default_make_border_back_(brush* brush, block_model* self, dimension* dim, block_behavior* block,
-                                     const pos2d& pos);
+    static void default_make_block_(brush* brush, block_model* self, dimension* dim, const chunk_neighborhood& nb,
+                                    block_behavior* block, const pos2d& pos);
+    static void default_make_border_(brush* brush, block_model* self, dimension* dim, const chunk_neighborhood& nb,
+                                     block_behavior* block, const pos2d& pos);
+    static void default_make_border_back_(brush* brush, block_model* self, dimension* dim,
+                                          const chunk_neighborhood& nb, block_behavior* block, const pos2d& pos);
+    static void default_make_block_area_(brush* brush, block_model* self, dimension* dim,
+                                         const chunk_neighborhood& nb, block_behavior* block, const pos2i& pos,
+                                         const pos2i& size);
+    // cycle through the cells of the texture, #anim_fps frames per second.
+    static void default_make_instance_(block_model* self, dimension* dim, block_behavior* block, const pos2i& pos,
+                                       block_instance& out);
+    // the program instanced blocks are drawn with.
+    static std::shared_ptr<program> instance_program_();
+    // bind the uvs of the model texture for #instance_program_.
+    static void set_instance_uniforms_(block_model* self, program* program);
+
+    // check if the block can be merged with its neighbours by greedy meshing.
+    static bool can_greedy_(block_behavior* block);
+    // check if the cells #c0 and #c0 + 1 on an axis keep the uvs continuous when merged.
+    static bool greedy_joinable_(block_behavior* block, int c0);
 };
 
 }  // namespace arc
\ No newline at end of file
@@ -1,27 +1,80 @@
 #include "render/chunk_model.h"
 
 #include <algorithm>
+#include <cstring>
 #include <vector>
 
 #include "chunk_model.h"
 #include "core/log.h"
-#include "core/thrp.h"
 #include "ctt.h"
+#include "core/time.h"
+#include "gfx/instance.h"
+#include "gfx/shader.h"
 #include "render/block_model.h"
+#include "render/liquid_model.h"
 #include "render/chunk_model.h"
+#include "render/mesh_scheduler.h"
+#include "render/region_model.h"
 #include "world/block.h"
 #include "world/chunk.h"
+#include "world/chunknb.h"
 #include "world/dim.h"
 #include "world/liquid.h"
 #include "world/pos.h"
 
 namespace arc {
 
+static std::atomic_uint32_t mesh_serial_ = 0;
+
 static bool cmp_sorted_draw_(const chunk_model::sorted_draw_& d1, const chunk_model::sorted_draw_& d2) {
     if (d1.obj != d2.obj) return d1.obj < d2.obj;
     return d1.pos < d2.pos;
 }
 
+// merge the cells of #grid holding the same block into larger quads.
+// cells left as nullptr are meshed one by one elsewhere.
+static void greedy_mesh_(chunk* parent, const chunk_neighborhood& nb, brush* brush_,
+                         block_behavior* (&grid)[ARC_CHUNK_SIZE][ARC_CHUNK_SIZE]) {
+    bool done[ARC_CHUNK_SIZE][ARC_CHUNK_SIZE] = {};
+
+    for (int j = 0; j < ARC_CHUNK_SIZE; j++) {
+        for (int i = 0; i < ARC_CHUNK_SIZE; i++) {
+            block_behavior* block = grid[i][j];
+            if (block == nullptr || done[i][j]) continue;
+
+            int x = parent->min_x + i;
+            int y = parent->min_y + j;
+
+            // grow along x first, then try to extend the whole run downwards.
+            int w = 1;
+            while (i + w < ARC_CHUNK_SIZE && grid[i + w][j] == block && !done[i + w][j] &&
+                   block_model::greedy_joinable_(block, x + w - 1))
+                w++;
+
+            int h = 1;
+            while (j + h < ARC_CHUNK_SIZE && block_model::greedy_joinable_(block, y + h - 1)) {
+                bool row = true;
+                for (int k = 0; k < w && row; k++) row = grid[i + k][j + h] == block && !done[i + k][j + h];
+                if (!row) break;
+                h++;
+            }
+
+            for (int k = 0; k < w; k++)
+                for (int l = 0; l < h; l++) done[i + k][j + l] = true;
+
+            block->model->make_block_area(brush_, block->model, parent->dim, nb, block, {x, y}, {w, h});
+        }
+    }
+}
+
+// chunk meshes are written compact, relative to their region so the region can merge them as they are.
+static brush* retry_compact_(mesh* msh, chunk* parent) {
+    brush* brush_ = msh->retry();
+    brush_->state_.format = vertex_format::compact;
+    brush_->state_.origin = region_model::origin_of(parent->pos);
+    return brush_;
+}
+
 void chunk_model::init(chunk* chunk_) {
     parent = chunk_;
     for (int i = 0; i < ARC_CHUNK_MESH_LAYER_COUNT; i++) {
@@ -30,11 +83,12 @@ void chunk_model::init(chunk* chunk_) {
     }
 }
 
-void chunk_model::instant_rebuild(int layer) {
+void chunk_model::instant_rebuild(int layer, const chunk_neighborhood& nb) {
     int x0 = parent->pos.x * ARC_CHUNK_SIZE;
     int y0 = parent->pos.y * ARC_CHUNK_SIZE;
     std::vector<sorted_draw_> borders;
     brush* brush_ = nullptr;
+    block_behavior* greedy[ARC_CHUNK_SIZE][ARC_CHUNK_SIZE] = {};
 
     switch (static_cast<chunk_mesh_layer>(layer)) {
         case chunk_mesh_layer::back_block:
@@ -42,9 +96,12 @@ void chunk_model::instant_rebuild(int layer) {
             built[layer + 1] = false;
             // back block mesh
             unmeshed_back_blocks.clear();
-            brush_ = meshes[layer]->retry();
+            begin_spans_(layer, patchable[layer]);
+            begin_spans_(layer + 1, patchable[layer]);
+            brush_ = retry_compact_(meshes[layer].get(), parent);
 
             scan_cxc(parent, [&](const pos2i& pos) {
+                int first = meshes[layer]->buffer->vertex_count / 4;
                 block_behavior* block = parent->find_back_block(pos);
                 if (block == block_void) return;
 
@@ -52,26 +109,39 @@ void chunk_model::instant_rebuild(int layer) {
                 if (block->model->dynamic_render && rself) {
                     unmeshed_back_blocks.emplace_back(pos, block);
                 } else {
-                    if (rself) block->model->make_block(brush_, block->model, parent->dim, block, pos.raw_2d());
+                    if (rself && !patchable[layer] && block_model::can_greedy_(block))
+                        greedy[pos.x - x0][pos.y - y0] = block;
+                    else if (rself)
+                        block->model->make_block(brush_, block->model, parent->dim, nb, block, pos.raw_2d());
                     borders.emplace_back(pos, block);
                 }
+                span_cell_(layer, pos, first);
             });
+            greedy_mesh_(parent, nb, brush_, greedy);
+            end_spans_(layer);
 
             std::sort(unmeshed_back_blocks.begin(), unmeshed_back_blocks.end(), cmp_sorted_draw_);
             meshes[layer]->record();
 
             // back block border mesh
             std::sort(borders.begin(), borders.end(), cmp_sorted_draw_);
-            brush_ = meshes[layer + 1]->retry();
+            brush_ = retry_compact_(meshes[layer + 1].get(), parent);
             for (auto& d : borders) {
-                d.obj->model->make_border_back(brush_, d.obj->model, parent->dim, d.obj, d.pos.raw_2d());
+                int first = meshes[layer + 1]->buffer->vertex_count / 4;
+                d.obj->model->make_border_back(brush_, d.obj->model, parent->dim, nb, d.obj, d.pos.raw_2d());
+                span_cell_(layer + 1, d.pos, first);
             }
+            end_spans_(layer + 1);
             meshes[layer + 1]->record();
 
             // push to front buffer
             unmeshed_back_blocks_used = unmeshed_back_blocks;
             std::swap(meshes[layer], meshes_used[layer]);
             std::swap(meshes[layer + 1], meshes_used[layer + 1]);
+            std::swap(spans[layer], spans_used[layer]);
+            std::swap(spans[layer + 1], spans_used[layer + 1]);
+            mesh_version[layer] = ++mesh_serial_;
+            mesh_version[layer + 1] = ++mesh_serial_;
             built[layer] = true;
             built[layer + 1] = true;
             break;
@@ -79,7 +149,7 @@ void chunk_model::instant_rebuild(int layer) {
             built[layer] = false;
             // furniture mesh
             unmeshed_furnitures.clear();
-            brush_ = meshes[layer]->retry();
+            brush_ = retry_compact_(meshes[layer].get(), parent);
 
             scan_cxc(parent, [&](const pos2i& pos) {
                 block_behavior* block = parent->find_block(pos);
@@ -88,7 +158,7 @@ void chunk_model::instant_rebuild(int layer) {
                 if (block->model->dynamic_render) {
                     unmeshed_furnitures.emplace_back(pos, block);
                 } else {
-                    block->model->make_block(brush_, block->model, parent->dim, block, pos.raw_2d());
+                    block->model->make_block(brush_, block->model, parent->dim, nb, block, pos.raw_2d());
                 }
             });
 
@@ -98,6 +168,7 @@ void chunk_model::instant_rebuild(int layer) {
             // push to front buffer
             unmeshed_furnitures_used = unmeshed_furnitures;
             std::swap(meshes[layer], meshes_used[layer]);
+            mesh_version[layer] = ++mesh_serial_;
             built[layer] = true;
             break;
         case chunk_mesh_layer::block:
@@ -105,35 +176,51 @@ void chunk_model::instant_rebuild(int layer) {
             built[layer + 1] = false;
             // block mesh
             unmeshed_blocks.clear();
-            brush_ = meshes[layer]->retry();
+            begin_spans_(layer, patchable[layer]);
+            begin_spans_(layer + 1, patchable[layer]);
+            brush_ = retry_compact_(meshes[layer].get(), parent);
 
             scan_cxc(parent, [&](const pos2i& pos) {
+                int first = meshes[layer]->buffer->vertex_count / 4;
                 block_behavior* block = parent->find_block(pos);
                 if (block == block_void) return;
 
                 if (block->model->dynamic_render) {
                     unmeshed_blocks.emplace_back(pos, block);
                 } else {
-                    block->model->make_block(brush_, block->model, parent->dim, block, pos.raw_2d());
+                    if (!patchable[layer] && block_model::can_greedy_(block))
+                        greedy[pos.x - x0][pos.y - y0] = block;
+                    else
+                        block->model->make_block(brush_, block->model, parent->dim, nb, block, pos.raw_2d());
                     borders.emplace_back(pos, block);
                 }
+                span_cell_(layer, pos, first);
             });
+            greedy_mesh_(parent, nb, brush_, greedy);
+            end_spans_(layer);
 
             std::sort(unmeshed_blocks.begin(), unmeshed_blocks.end(), cmp_sorted_draw_);
             meshes[layer]->record();
 
             // block border mesh
             std::sort(borders.begin(), borders.end(), cmp_sorted_draw_);
-            brush_ = meshes[layer + 1]->retry();
+            brush_ = retry_compact_(meshes[layer + 1].get(), parent);
             for (auto& d : borders) {
-                d.obj->model->make_border(brush_, d.obj->model, parent->dim, d.obj, d.pos.raw_2d());
+                int first = meshes[layer + 1]->buffer->vertex_count / 4;
+                d.obj->model->make_border(brush_, d.obj->model, parent->dim, nb, d.obj, d.pos.raw_2d());
+                span_cell_(layer + 1, d.pos, first);
             }
+            end_spans_(layer + 1);
             meshes[layer + 1]->record();
 
             // push to front buffer
             unmeshed_blocks_used = unmeshed_blocks;
             std::swap(meshes[layer], meshes_used[layer]);
             std::swap(meshes[layer + 1], meshes_used[layer + 1]);
+            std::swap(spans[layer], spans_used[layer]);
+            std::swap(spans[layer + 1], spans_used[layer + 1]);
+            mesh_version[layer] = ++mesh_serial_;
+            mesh_version[layer + 1] = ++mesh_serial_;
             built[layer] = true;
             built[layer + 1] = true;
             break;
@@ -142,116 +229,290 @@ void chunk_model::instant_rebuild(int layer) {
     }
 }
 
-void chunk_model::tick() {
-    for (int i = 0; i < ARC_CHUNK_MESH_LAYER_COUNT; i++) {
-        bool expected = true;
-        if (should_rebuild[i].compare_exchange_strong(expected, false)) {
-#ifdef ARC_MULTITHREADED_MESH_BUILD
-            thread_pool::execute([this, i]() { instant_rebuild(i); });
-#else
-            instant_rebuild(i);
-#endif
+static int cell_index_(const pos2i& pos) { return wrap_pos(pos.x) + wrap_pos(pos.y) * ARC_CHUNK_SIZE; }
+
+void chunk_model::begin_spans_(int layer, bool on) {
+    spans[layer].assign(on ? ARC_CHUNK_SIZE * ARC_CHUNK_SIZE : 0, cell_span_());
+}
+
+void chunk_model::span_cell_(int layer, const pos2i& pos, int first) {
+    if (spans[layer].empty()) return;
+    complex_buffer* buf = meshes[layer]->buffer.get();
+    cell_span_& span = spans[layer][cell_index_(pos)];
+    span.first = first;
+    span.count = buf->vertex_count / 4 - first;
+    span.cap = span.count + ARC_CHUNK_PATCH_SLACK;
+    buf->pad_quads(ARC_CHUNK_PATCH_SLACK, ARC_CHUNK_VERTEX_STRIDE);
+}
+
+void chunk_model::end_spans_(int layer) {
+    // cells that wrote nothing still get some room, so that placing a block there can be patched.
+    complex_buffer* buf = meshes[layer]->buffer.get();
+    for (auto& span : spans[layer]) {
+        if (span.cap != 0) continue;
+        span.first = buf->vertex_count / 4;
+        span.cap = ARC_CHUNK_PATCH_SLACK;
+        buf->pad_quads(ARC_CHUNK_PATCH_SLACK, ARC_CHUNK_VERTEX_STRIDE);
+    }
+}
+
+static bool unmeshed_at_(const std::vector<chunk_model::sorted_draw_>& draws, const pos2i& pos) {
+    for (auto& d : draws)
+        if (d.pos == pos) return true;
+    return false;
+}
+
+// the brush patches are drawn into. only used on the tick thread.
+static std::shared_ptr<complex_buffer> patch_buf_;
+static std::unique_ptr<brush> patch_brush_;
+
+bool chunk_model::patch_cell(int layer, const pos2i& pos, const chunk_neighborhood& nb) {
+    if (!built[layer] || spans_used[layer].empty()) return false;
+    // a full rebuild is on the way anyway.
+    int base = layer == 1 || layer == 4 ? layer - 1 : layer;
+    if (dirty_layers & (1 << base)) return false;
+
+    if (patch_buf_ == nullptr) {
+        patch_buf_ = complex_buffer::make();
+        patch_brush_ = patch_buf_->derive_brush();
+        patch_brush_->is_in_mesh_ = true;
+    }
+    patch_buf_->clear();
+    brush* brush_ = patch_brush_.get();
+    brush_->state_.format = vertex_format::compact;
+    brush_->state_.origin = region_model::origin_of(parent->pos);
+
+    switch (static_cast<chunk_mesh_layer>(layer)) {
+        case chunk_mesh_layer::back_block:
+        case chunk_mesh_layer::back_block_border: {
+            if (unmeshed_at_(unmeshed_back_blocks_used, pos)) return false;
+            block_behavior* block = parent->find_back_block(pos);
+            if (block == block_void) break;
+            bool rself = parent->find_block(pos)->shape != block_shape::opaque;
+            if (block->model->dynamic_render && rself) return false;
+            if (layer == static_cast<int>(chunk_mesh_layer::back_block_border))
+                block->model->make_border_back(brush_, block->model, parent->dim, nb, block, pos.raw_2d());
+            else if (rself)
+                block->model->make_block(brush_, block->model, parent->dim, nb, block, pos.raw_2d());
+            break;
+        }
+        case chunk_mesh_layer::block:
+        case chunk_mesh_layer::block_border: {
+            if (unmeshed_at_(unmeshed_blocks_used, pos)) return false;
+            block_behavior* block = parent->find_block(pos);
+            if (block == block_void) break;
+            if (block->model->dynamic_render) return false;
+            if (layer == static_cast<int>(chunk_mesh_layer::block_border))
+                block->model->make_border(brush_, block->model, parent->dim, nb, block, pos.raw_2d());
+            else
+                block->model->make_block(brush_, block->model, parent->dim, nb, block, pos.raw_2d());
+            break;
+        }
+        default:
+            return false;
+    }
+
+    mesh* msh = meshes_used[layer].get();
+    cell_span_& span = spans_used[layer][cell_index_(pos)];
+    int count = patch_buf_->vertex_count / 4;
+    if (count > span.cap) return false;
+
+    if (count > 0) {
+        // the mesh is drawn with one texture, a cell cannot bring another one.
+        auto& tex = msh->state.texture;
+        auto& ptex = brush_->state_.texture;
+        if (tex == nullptr)
+            msh->state = brush_->state_;
+        else if (ptex == nullptr || tex->texture_id_ != ptex->texture_id_)
+            return false;
+    }
+
+    const size_t quad_bytes = 4 * ARC_CHUNK_VERTEX_STRIDE;
+    complex_buffer* buf = msh->buffer.get();
+    size_t off = span.first * quad_bytes;
+    std::memcpy(buf->vertex_buf.data() + off, patch_buf_->vertex_buf.data(), count * quad_bytes);
+    std::memset(buf->vertex_buf.data() + off + count * quad_bytes, 0, (span.cap - count) * quad_bytes);
+    buf->mark_dirty_(off, off + span.cap * quad_bytes);
+    span.count = count;
+    mesh_version[layer] = ++mesh_serial_;
+    return true;
+}
+
+void chunk_model::patch(const pos2i& pos, chunk_mesh_layer layer) {
+    int l = static_cast<int>(layer);
+    if (layer != chunk_mesh_layer::back_block && layer != chunk_mesh_layer::block) {
+        rebuild(pos, layer);
+        return;
+    }
+
+    mesh_scheduler* executor = parent->dim->mesh_executor.get();
+    if (executor == nullptr) return;
+
+    // the block itself only touches its own cell, but the borders depend on the 8 neighbours.
+    chunk_neighborhood nb = chunk_neighborhood::around(parent->dim, parent->pos);
+    bool self_ok = patch_cell(l, pos, nb);
+    if (!self_ok) {
+        // keep room for patches from now on, the layer is being edited.
+        patchable[l] = true;
+        executor->mark(parent, 1 << l);
+    }
+
+    for (int dx = -1; dx <= 1; dx++) {
+        for (int dy = -1; dy <= 1; dy++) {
+            pos2i p = pos2i(pos.x + dx, pos.y + dy);
+            chunk* c = nb.find_chunk(p.x, p.y);
+            if (c == nullptr || (c == parent && !self_ok)) continue;
+            if (c->model->patch_cell(l + 1, p, nb)) continue;
+            c->model->patchable[l] = true;
+            executor->mark(c, 1 << l);
         }
     }
 }
 
-static void try_rebuild_at(int l, int x, int y) {
-    auto ptr = fast_get_chunk(x, y);
-    if (ptr != nullptr) ptr->model->should_rebuild[l] = true;
+static void try_rebuild_at(dimension* dim, int l, int x, int y) {
+    auto ptr = dim->find_chunk_by_block({x, y});
+    if (ptr && dim->mesh_executor) dim->mesh_executor->mark(ptr, 1 << l);
 }
 
 void chunk_model::rebuild(const pos2i& pos, chunk_mesh_layer layer) {
     int l = static_cast<int>(layer);
-    should_rebuild[l] = true;
+    if (!parent->dim->mesh_executor) return;
+    parent->dim->mesh_executor->mark(parent, 1 << l);
     int x = pos.x;
     int y = pos.y;
     bool d10 = (x & (ARC_CHUNK_SIZE - 1)) == 0;
     bool d11 = (x & (ARC_CHUNK_SIZE - 1)) == ARC_CHUNK_SIZE - 1;
     bool d20 = (y & (ARC_CHUNK_SIZE - 1)) == 0;
     bool d21 = (y & (ARC_CHUNK_SIZE - 1)) == ARC_CHUNK_SIZE - 1;
-    if (d10) try_rebuild_at(l, x - 1, y);
-    if (d11) try_rebuild_at(l, x + 1, y);
-    if (d20) try_rebuild_at(l, x, y - 1);
-    if (d21) try_rebuild_at(l, x, y + 1);
-    if (d10 && d20) try_rebuild_at(l, x - 1, y - 1);
-    if (d11 && d20) try_rebuild_at(l, x + 1, y - 1);
-    if (d10 && d21) try_rebuild_at(l, x - 1, y + 1);
-    if (d11 && d21) try_rebuild_at(l, x + 1, y + 1);
+    if (d10) try_rebuild_at(parent->dim, l, x - 1, y);
+    if (d11) try_rebuild_at(parent->dim, l, x + 1, y);
+    if (d20) try_rebuild_at(parent->dim, l, x, y - 1);
+    if (d21) try_rebuild_at(parent->dim, l, x, y + 1);
+    if (d10 && d20) try_rebuild_at(parent->dim, l, x - 1, y - 1);
+    if (d11 && d20) try_rebuild_at(parent->dim, l, x + 1, y - 1);
+    if (d10 && d21) try_rebuild_at(parent->dim, l, x - 1, y + 1);
+    if (d11 && d21) try_rebuild_at(parent->dim, l, x + 1, y + 1);
 }
 
-void chunk_model::render(brush* brush, chunk_mesh_layer layer) {
+void chunk_model::render(brush* brush, chunk_mesh_layer layer, const chunk_neighborhood& nb) {
     int l = static_cast<int>(layer);
     if (!built[l]) return;
     meshes_used[l]->draw(brush);
+    render_unmeshed(brush, layer, nb);
+}
+
+void chunk_model::draw_unmeshed_blocks_(brush* brush, int layer, const std::vector<sorted_draw_>& draws,
+                                        const chunk_neighborhood& nb) {
+    std::vector<instance_group_>& groups = instanced[layer];
+    for (auto& g : groups) g.batch->clear();
+
+    for (auto& d : draws) {
+        block_model* model = d.obj->model;
+        if (model->make_instance == nullptr || model->tex == nullptr) {
+            model->make_block(brush, model, parent->dim, nb, d.obj, d.pos.raw_2d());
+            continue;
+        }
+
+        // the unmeshed lists are sorted by block, so the group is nearly always the last one.
+        instance_group_* group = nullptr;
+        for (auto it = groups.rbegin(); it != groups.rend() && group == nullptr; ++it)
+            if (it->model == model) group = &*it;
+        if (group == nullptr) {
+            groups.push_back({model, instance_batch::make()});
+            group = &groups.back();
+        }
+
+        block_instance inst;
+        model->make_instance(model, parent->dim, d.obj, d.pos, inst);
+        group->batch->push(inst);
+    }
+
+    for (auto& g : groups) {
+        block_model* model = g.model;
+        g.batch->draw(brush, block_model::instance_program_(), model->tex,
+                      [model](program* program) { block_model::set_instance_uniforms_(model, program); });
+    }
+}
+
+void chunk_model::render_unmeshed(brush* brush, chunk_mesh_layer layer, const chunk_neighborhood& nb) {
+    int l = static_cast<int>(layer);
+    if (!built[l]) return;
     switch (layer) {
         case chunk_mesh_layer::back_block:
-            for (auto& d : unmeshed_back_blocks_used)
-                d.obj->model->make_block(brush, d.obj->model, parent->dim, d.obj, d.pos.raw_2d());
+            draw_unmeshed_blocks_(brush, l, unmeshed_back_blocks_used, nb);
             break;
         case chunk_mesh_layer::back_block_border:
             for (auto& d : unmeshed_back_blocks_used)
-                d.obj->model->make_border_back(brush, d.obj->model, parent->dim, d.obj, d.pos.raw_2d());
+                d.obj->model->make_border_back(brush, d.obj->model, parent->dim, nb, d.obj, d.pos.raw_2d());
             break;
         case chunk_mesh_layer::furniture:
-            for (auto& d : unmeshed_furnitures_used)
-                d.obj->model->make_block(brush, d.obj->model, parent->dim, d.obj, d.pos.raw_2d());
+            draw_unmeshed_blocks_(brush, l, unmeshed_furnitures_used, nb);
             break;
         case chunk_mesh_layer::block:
-            for (auto& d : unmeshed_blocks_used)
-                d.obj->model->make_block(brush, d.obj->model, parent->dim, d.obj, d.pos.raw_2d());
+            draw_unmeshed_blocks_(brush, l, unmeshed_blocks_used, nb);
             break;
         case chunk_mesh_layer::block_border:
             for (auto& d : unmeshed_blocks_used)
-                d.obj->model->make_border(brush, d.obj->model, parent->dim, d.obj, d.pos.raw_2d());
+                d.obj->model->make_border(brush, d.obj->model, parent->dim, nb, d.obj, d.pos.raw_2d());
             break;
         default:
             break;
     }
 }
 
-static obs<chunk> ccache_[ARC_CHUNK_CACHE_SIZE_X][ARC_CHUNK_CACHE_SIZE_Y] = {nullptr};
-static int corix_ = -ARC_CHUNK_CACHE_SIZE_X / 2, coriy_ = -ARC_CHUNK_CACHE_SIZE_Y / 2;
-
-obs<chunk> fast_get_chunk(int x, int y) {
-    x = findc(x) - corix_;
-    y = findc(y) - coriy_;
-    if (x < 0 || x >= ARC_CHUNK_CACHE_SIZE_X || y < 0 || y >= ARC_CHUNK_CACHE_SIZE_Y) {
-        print_throw(log_level::fatal, "chunk cache is not big enought");
-    }
-    return ccache_[x][y];
+void chunk_model::mark_liquid(const pos2i& pos) {
+    liquid_dirty = true;
+    if (wrap_pos(pos.y) != ARC_CHUNK_SIZE - 1) return;
+    auto below = parent->dim->find_chunk(pos2i(parent->pos.x, parent->pos.y + 1));
+    if (below) below->model->liquid_dirty = true;
 }
 
-block_behavior* fast_get_block(int x, int y) {
-    auto chunk_ = fast_get_chunk(x, y);
-    return chunk_ ? chunk_->find_block({x, y}) : block_void;
+static void set_liquid_time_(program* program) {
+    program->cached_uniforms[2].set(clock::now().seconds);
 }
 
-block_behavior* fast_get_back_block(int x, int y) {
-    auto chunk_ = fast_get_chunk(x, y);
-    return chunk_ ? chunk_->find_back_block({x, y}) : block_void;
+void chunk_model::rebuild_liquid(const chunk_neighborhood& nb) {
+    unmeshed_liquids.clear();
+    liquid_meshes_used = 0;
+
+    auto buffer_of = [this](const std::shared_ptr<texture>& tex) -> complex_buffer* {
+        for (int i = 0; i < liquid_meshes_used; i++)
+            if (liquid_meshes[i]->state.texture->texture_id_ == tex->texture_id_) return liquid_meshes[i]->buffer.get();
+
+        if (liquid_meshes_used == static_cast<int>(liquid_meshes.size())) liquid_meshes.push_back(mesh::make());
+        mesh* msh = liquid_meshes[liquid_meshes_used++].get();
+        msh->buffer->clear();
+        msh->state.mode = graph_mode::textured_quad;
+        msh->state.texture = tex;
+        msh->state.prog = liquid_model::program_();
+        msh->state.callback_uniform = set_liquid_time_;
+        return msh->buffer.get();
+    };
+
+    scan_cxc(parent, [&](const pos2i& pos) {
+        liquid_stack qstack = parent->find_liquid_stack(pos);
+        if (qstack.is_empty()) return;
+        liquid_model* model = qstack.liquid->model;
+        if (model->dynamic_render)
+            unmeshed_liquids.push_back(pos);
+        else
+            liquid_model::default_cache_liquid_(buffer_of, model, nb, qstack, pos);
+    });
 }
 
-liquid_stack fast_get_liquid_stack(int x, int y) {
-    auto chunk_ = fast_get_chunk(x, y);
-    return chunk_ ? chunk_->find_liquid_stack({x, y}) : liquid_stack(liquid_void, 0);
+void chunk_model::render_liquid(brush* brush, const chunk_neighborhood& nb) {
+    if (liquid_dirty.exchange(false)) rebuild_liquid(nb);
+    draw_liquid(brush, nb);
 }
 
-void reflush_chunk_models_(dimension* dim, const pos2i& ct) {
-    int x = ct.x;
-    int y = ct.y;
-    corix_ = x - ARC_CHUNK_CACHE_SIZE_X / 2;
-    coriy_ = y - ARC_CHUNK_CACHE_SIZE_Y / 2;
-
-    for (int i = 0; i < ARC_CHUNK_CACHE_SIZE_X; i++) {
-        for (int j = 0; j < ARC_CHUNK_CACHE_SIZE_Y; j++) {
-            pos2i cpos = pos2i(corix_ + i, coriy_ + j);
-            auto chunk_ = dim->find_chunk(cpos);
-            if (chunk_)
-                ccache_[i][j] = chunk_;
-            else
-                ccache_[i][j] = nullptr;
-        }
+void chunk_model::draw_liquid(brush* brush, const chunk_neighborhood& nb) {
+    for (int i = 0; i < liquid_meshes_used; i++) liquid_meshes[i]->draw(brush);
+    for (auto& pos : unmeshed_liquids) {
+        liquid_stack qstack = parent->find_liquid_stack(pos);
+        if (!qstack.is_empty())
+            qstack.liquid->model->make_liquid(brush, qstack.liquid->model, parent->dim, nb, qstack,
+                                              static_cast<pos2d>(pos));
     }
 }
 
-}  // namespace arc
\ No newline at end of file
+}  // namespace arc
@@ -10,8 +10,10 @@
 #include "world/dim.h"
 #include "world/pos.h"
 
-#define ARC_CHUNK_CACHE_SIZE_X 10
-#define ARC_CHUNK_CACHE_SIZE_Y 8
+// quads reserved after each cell of an edited chunk layer, so that edits can be patched in place.
+#define ARC_CHUNK_PATCH_SLACK 2
+// bytes of a vertex in chunk meshes (vertex_compact).
+#define ARC_CHUNK_VERTEX_STRIDE 12
 // #define ARC_MULTITHREADED_MESH_BUILD
 
 namespace arc {
@@ -27,6 +29,9 @@ enum class chunk_mesh_layer {
 };
 
 struct chunk;
+struct chunk_neighborhood;
+struct block_model;
+struct instance_batch;
 
 struct chunk_model {
     struct sorted_draw_ {
@@ -34,10 +39,27 @@ struct chunk_model {
         block_behavior* obj;
     };
 
+    // dynamic blocks of one model drawn with a single instanced call.
+    struct instance_group_ {
+        block_model* model;
+        std::shared_ptr<instance_batch> batch;
+    };
+
+    // the quads a cell owns in a layer mesh.
+    struct cell_span_ {
+        int first = 0;
+        int count = 0;
+        int cap = 0;
+    };
+
     chunk* parent;
-    std::atomic_bool should_rebuild[ARC_CHUNK_MESH_LAYER_COUNT] = {false};
+    // bits of chunk_mesh_layer waiting for the mesh_scheduler.
+    std::atomic_uint8_t dirty_layers = 0;
+    std::atomic_bool queued_ = false;
     std::atomic_bool ao_rebuild = false;
     std::atomic_bool built[ARC_CHUNK_MESH_LAYER_COUNT] = {false};
+    // changes whenever the front mesh of a layer changes, unique across chunks. 0 means never built.
+    std::atomic_uint32_t mesh_version[ARC_CHUNK_MESH_LAYER_COUNT] = {0};
     // double buffer
     std::shared_ptr<mesh> meshes[ARC_CHUNK_MESH_LAYER_COUNT];
     std::vector<sorted_draw_> unmeshed_back_blocks;
@@ -47,18 +69,43 @@ struct chunk_model {
     std::vector<sorted_draw_> unmeshed_back_blocks_used;
     std::vector<sorted_draw_> unmeshed_furnitures_used;
     std::vector<sorted_draw_> unmeshed_blocks_used;
+    // cell to quad mapping, only kept for patchable layers.
+    std::vector<cell_span_> spans[ARC_CHUNK_MESH_LAYER_COUNT];
+    std::vector<cell_span_> spans_used[ARC_CHUNK_MESH_LAYER_COUNT];
+    // set after the first edit of a layer. patchable layers reserve slack and skip greedy meshing.
+    bool patchable[ARC_CHUNK_MESH_LAYER_COUNT] = {false};
+    // cached liquid meshes, one per texture. only the first #liquid_meshes_used are valid.
+    std::vector<std::shared_ptr<mesh>> liquid_meshes;
+    int liquid_meshes_used = 0;
+    std::vector<pos2i> unmeshed_liquids;
+    std::vector<instance_group_> instanced[ARC_CHUNK_MESH_LAYER_COUNT];
+    std::atomic_bool liquid_dirty = true;
 
     void init(chunk* chunk_);
-    void tick();
-    void instant_rebuild(int layer);
+    // #nb should cover the chunk and the chunks around it, borders look into them.
+    void instant_rebuild(int layer, const chunk_neighborhood& nb);
     void rebuild(const pos2i& pos, chunk_mesh_layer layer);
-    void render(brush* brush, chunk_mesh_layer layer);
-};
+    // rewrite a single edited cell and the borders around it in place.
+    // falls back to #rebuild when the change does not fit.
+    void patch(const pos2i& pos, chunk_mesh_layer layer);
+    // rewrite the quads of one cell in the front mesh of a layer. returns false if it cannot be done in place.
+    bool patch_cell(int layer, const pos2i& pos, const chunk_neighborhood& nb);
+    void render(brush* brush, chunk_mesh_layer layer, const chunk_neighborhood& nb);
+    // only draw the dynamic blocks of a layer, the static mesh is drawn by the region.
+    void render_unmeshed(brush* brush, chunk_mesh_layer layer, const chunk_neighborhood& nb);
+    // a liquid changed at #pos, the cells under it change as well.
+    void mark_liquid(const pos2i& pos);
+    void rebuild_liquid(const chunk_neighborhood& nb);
+    // draw the cached liquids, the mesh is rebuilt first if it is dirty.
+    void render_liquid(brush* brush, const chunk_neighborhood& nb);
+    // draw the cached liquids as they are, even if dirty.
+    void draw_liquid(brush* brush, const chunk_neighborhood& nb);
 
-obs<chunk> fast_get_chunk(int x, int y);
-block_behavior* fast_get_block(int x, int y);
-block_behavior* fast_get_back_block(int x, int y);
-liquid_stack fast_get_liquid_stack(int x, int y);
-void reflush_chunk_models_(dimension* dim, const pos2i& ct);
+    void draw_unmeshed_blocks_(brush* brush, int layer, const std::vector<sorted_draw_>& draws,
+                               const chunk_neighborhood& nb);
+    void begin_spans_(int layer, bool on);
+    void span_cell_(int layer, const pos2i& pos, int first);
+    void end_spans_(int layer);
+};
 
 }  // namespace arc
\ No newline at end of file
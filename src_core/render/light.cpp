@@ -1,5 +1,6 @@
 #include "render/light.h"
 
+#include <chrono>
 #include <memory>
 #include <utility>
 
@@ -9,6 +10,7 @@
 #include "light.h"
 #include "render/chunk_model.h"
 #include "world/block.h"
+#include "world/chunknb.h"
 #include "world/dim.h"
 #include "world/dimh.h"
 #include "world/liquid.h"
@@ -19,8 +21,8 @@ namespace arc {
 static std::unique_ptr<float[]> empty_lm = std::make_unique<float[]>(7);
 ldata_ ldata_::empty = ldata_(nullptr, empty_lm.get());
 
-void ldata_::ao_block(int x, int y) {
-    block_behavior* b = fast_get_block(x, y);
+void ldata_::ao_block(const chunk_neighborhood& nb, int x, int y) {
+    block_behavior* b = nb.find_block(x, y);
 
     const float ao_sim = 0.1;
 
@@ -32,14 +34,14 @@ void ldata_::ao_block(int x, int y) {
         data[6] = v;
     } else {
         int c = 0;
-        block_behavior* b0 = fast_get_block(x - 1, y - 1);
-        block_behavior* b1 = fast_get_block(x - 1, y);
-        block_behavior* b2 = fast_get_block(x - 1, y + 1);
-        block_behavior* b3 = fast_get_block(x, y - 1);
-        block_behavior* b4 = fast_get_block(x, y + 1);
-        block_behavior* b5 = fast_get_block(x + 1, y - 1);
-        block_behavior* b6 = fast_get_block(x + 1, y);
-        block_behavior* b7 = fast_get_block(x + 1, y + 1);
+        block_behavior* b0 = nb.find_block(x - 1, y - 1);
+        block_behavior* b1 = nb.find_block(x - 1, y);
+        block_behavior* b2 = nb.find_block(x - 1, y + 1);
+        block_behavior* b3 = nb.find_block(x, y - 1);
+        block_behavior* b4 = nb.find_block(x, y + 1);
+        block_behavior* b5 = nb.find_block(x + 1, y - 1);
+        block_behavior* b6 = nb.find_block(x + 1, y);
+        block_behavior* b7 = nb.find_block(x + 1, y + 1);
         bool bcc1 = b1->shape == block_shape::opaque;
         bool bcc3 = b3->shape == block_shape::opaque;
         bool bcc4 = b4->shape == block_shape::opaque;
@@ -164,8 +166,8 @@ void spread_pipe(ldata_& self, chunk* chunk, int x, int y, int idx) {
     }
 }
 
-void light_engine::spread(int x, int y) {
-    chunk* chunk = fast_get_chunk(x, y);
+void light_engine::spread(const chunk_neighborhood& nb, int x, int y) {
+    chunk* chunk = nb.find_chunk(x, y);
     if (chunk == nullptr) return;
 
     ldata_ data = at(x, y);
@@ -211,7 +213,7 @@ float light_engine::get_sky_shed(chunk* chunk, int x, int y, int pipe) {
     return 0.0;
 }
 
-void light_engine::tick(const quad& cam) {
+void light_engine::tick(const quad& cam, std::shared_ptr<chunk_neighborhood> view) {
     lorix = std::floor(cam.center_x()) - sx / 2.0;
     loriy = std::floor(cam.center_y()) - sy / 2.0;
 
@@ -231,15 +233,22 @@ void light_engine::tick(const quad& cam) {
 
     if (!start_lit) {
         start_lit = true;
-        thread_pool::execute([this, cam]() {
-            calculate(cam);
+        // the pass reaches a few blocks beyond the camera, collect those chunks before leaving the main thread.
+        quad window = cam;
+        window.inflate(ult_max / unit * 2, ult_max / unit * 2);
+        std::shared_ptr<chunk_neighborhood> nb = view;
+        if (nb == nullptr || !nb->covers(window))
+            nb = std::make_shared<chunk_neighborhood>(chunk_neighborhood::covering(dim, window, 0));
+        std::vector<light_source_> sources = collect_sources_(cam);
+        thread_pool::execute([this, cam, nb, sources = std::move(sources)]() {
+            calculate(cam, *nb, sources);
             render_meshes(cam);
             end_lit = true;
         });
     }
 }
 
-void light_engine::lit_smooth(float x, float y, float v1, float v2, float v3) {
+void light_engine::lit_smooth(const chunk_neighborhood& nb, float x, float y, float v1, float v2, float v3) {
     if (v1 <= dark_luminance && v2 <= dark_luminance && v3 <= dark_luminance) return;
 
     const int r = 3;
@@ -250,13 +259,13 @@ void light_engine::lit_smooth(float x, float y, float v1, float v2, float v3) {
         for (int ty = ly - r; ty < ly + r; ty += 1) {
             float dist2 = std::pow(tx - x, 2) + std::pow(ty - y, 2);
             if (dist2 < 1) dist2 = 1;
-            lit(tx, ty, v1 / dist2, v2 / dist2, v3 / dist2);
+            lit(nb, tx, ty, v1 / dist2, v2 / dist2, v3 / dist2);
         }
     }
 }
 
-void light_engine::lit(int x, int y, float v1, float v2, float v3) {
-    chunk* chunk = fast_get_chunk(x, y);
+void light_engine::lit(const chunk_neighborhood& nb, int x, int y, float v1, float v2, float v3) {
+    chunk* chunk = nb.find_chunk(x, y);
     if (chunk == nullptr) return;
 
     ldata_ data = at(x, y);
@@ -265,17 +274,38 @@ void light_engine::lit(int x, int y, float v1, float v2, float v3) {
     data.data[2] = std::max(data.data[2], v3 * amp);
 }
 
-void light_engine::calculate(const quad& cam) {
-    float spd = ult_max / unit / 2.0;
+// the blocks a light pass covers around #cam.
+static void light_window_(const quad& cam, int* x0, int* y0, int* x1, int* y1) {
+    float spd = light_engine::ult_max / light_engine::unit / 2.0;
+    *x0 = static_cast<int>(cam.x - spd);
+    *y0 = static_cast<int>(cam.y - spd);
+    *x1 = static_cast<int>(cam.prom_x() + spd);
+    *y1 = static_cast<int>(cam.prom_y() + spd);
+}
+
+std::vector<light_source_> light_engine::collect_sources_(const quad& cam) {
+    int x0, y0, x1, y1;
+    light_window_(cam, &x0, &y0, &x1, &y1);
+    quad aabb = quad();
+    aabb.resize(x1 - x0, y1 - y0);
+    aabb.locate_center((x1 + x0) / 2.0, (y1 + y0) / 2.0);
+
+    std::vector<light_source_> sources;
+    for (entity* e : dim_util::get_intersected_entities(dim, aabb)) {
+        if (!e->cast_light) continue;
+        float x = e->pos.x, y = e->pos.y;
+        sources.push_back({x, y, e->cast_light(e, 0), e->cast_light(e, 1), e->cast_light(e, 2)});
+    }
+    return sources;
+}
 
-    int x0 = static_cast<int>(cam.x - spd);
-    int y0 = static_cast<int>(cam.y - spd);
-    int x1 = static_cast<int>(cam.prom_x() + spd);
-    int y1 = static_cast<int>(cam.prom_y() + spd);
+void light_engine::calculate(const quad& cam, const chunk_neighborhood& nb, const std::vector<light_source_>& sources) {
+    int x0, y0, x1, y1;
+    light_window_(cam, &x0, &y0, &x1, &y1);
 
     for (int x = x0 - 1; x <= x1 + 1; x++) {
         for (int y = y0 - 1; y <= y1 + 1; y++) {
-            chunk* chunk = fast_get_chunk(x, y);
+            chunk* chunk = nb.find_chunk(x, y);
             if (chunk == nullptr) continue;
 
             ldata_ data = at(x, y);
@@ -283,31 +313,20 @@ void light_engine::calculate(const quad& cam) {
             data.data[1] = std::max(get_block_shed(chunk, x, y, 1), get_sky_shed(chunk, x, y, 1));
             data.data[2] = std::max(get_block_shed(chunk, x, y, 2), get_sky_shed(chunk, x, y, 2));
 
-            if (chunk->model->ao_rebuild) data.ao_block(x, y);
+            if (chunk->model->ao_rebuild) data.ao_block(nb, x, y);
         }
     }
 
-    quad aabb = quad();
-    aabb.resize(x1 - x0, y1 - y0);
-    aabb.locate_center((x1 + x0) / 2.0, (y1 + y0) / 2.0);
-
-    for (obs<entity> e : dim_util::get_intersected_entities(dim, aabb)) {
-        if (!e->cast_light) continue;
-        float r = e->cast_light(e, 0);
-        float g = e->cast_light(e, 1);
-        float b = e->cast_light(e, 2);
-
-        lit_smooth(e->pos.x, e->pos.y, r, g, b);
-    }
+    for (const light_source_& l : sources) lit_smooth(nb, l.x, l.y, l.r, l.g, l.b);
 
     for (int x = x1; x >= x0; x--)
-        for (int y = y1; y >= y0; y--) spread(x, y);
+        for (int y = y1; y >= y0; y--) spread(nb, x, y);
     for (int x = x0; x <= x1; x++)
-        for (int y = y0; y <= y1; y++) spread(x, y);
+        for (int y = y0; y <= y1; y++) spread(nb, x, y);
     for (int x = x0; x <= x1; x++)
-        for (int y = y1; y >= y0; y--) spread(x, y);
+        for (int y = y1; y >= y0; y--) spread(nb, x, y);
     for (int x = x1; x >= x0; x--)
-        for (int y = y0; y <= y1; y++) spread(x, y);
+        for (int y = y0; y <= y1; y++) spread(nb, x, y);
 }
 
 ldata_ light_engine::at(int x, int y) {
@@ -332,6 +351,7 @@ static void populate_lm_mesh(light_engine* engine, const quad& cam, std::shared_
     int cx1 = std::round(cam.prom_x() + overdraw);
 
     brush* brush_ = mesh->retry();
+    brush_->state_.format = engine->ldr_mesh ? vertex_format::ldr : vertex_format::standard;
 
     for (int x = cx0; x <= cx1; x++) {
         for (int y = cy0; y <= cy1; y++) {
@@ -345,8 +365,10 @@ static void populate_lm_mesh(light_engine* engine, const quad& cam, std::shared_
 }
 
 void light_engine::render_meshes(const quad& cam) {
+    auto start = std::chrono::steady_clock::now();
     populate_lm_mesh(this, cam, back_map, lm, true);
     populate_lm_mesh(this, cam, front_map, lm, false);
+    mesh_build_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 }
 
 }  // namespace arc
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <atomic>
 #include <memory>
+#include <vector>
 
 #include "core/math.h"
 
@@ -9,6 +10,7 @@ namespace arc {
 
 struct light_engine;
 struct color;
+struct chunk_neighborhood;
 
 struct ldata_ {
     static ldata_ empty;
@@ -16,7 +18,7 @@ struct ldata_ {
     light_engine* engine;
     float* data;
 
-    void ao_block(int x, int y);
+    void ao_block(const chunk_neighborhood& nb, int x, int y);
     void lit_block(color color[], int x, int y, bool isWall);
 };
 
@@ -25,6 +27,12 @@ struct chunk;
 struct mesh;
 struct framebuffer;
 
+// an entity light, copied on the main thread so the worker never reads entities.
+struct light_source_ {
+    float x, y;
+    float r, g, b;
+};
+
 struct light_engine {
     inline static constexpr float amp = 1.25;
     inline static constexpr float dark_luminance = 0.05;
@@ -46,18 +54,25 @@ struct light_engine {
     dimension* dim = nullptr;
     std::atomic_bool end_lit = false;
     std::atomic_bool start_lit = false;
+    // build the light maps with unorm8 colours, brighter than 1 is clamped per vertex instead of per pixel.
+    bool ldr_mesh = false;
+    // time the last #render_meshes took.
+    std::atomic<double> mesh_build_seconds = 0;
 
     void init(dimension* dim);
     color color_stably(float x, float y);
-    void tick(const quad& cam);
-    void calculate(const quad& cam);
-    void lit_smooth(float x, float y, float v1, float v2, float v3);
-    void lit(int x, int y, float v1, float v2, float v3);
+    // #view may be the chunks collected for the render view, they are used if they cover the light window.
+    void tick(const quad& cam, std::shared_ptr<chunk_neighborhood> view = nullptr);
+    // the entity lights around #cam, main thread only.
+    std::vector<light_source_> collect_sources_(const quad& cam);
+    void calculate(const quad& cam, const chunk_neighborhood& nb, const std::vector<light_source_>& sources);
+    void lit_smooth(const chunk_neighborhood& nb, float x, float y, float v1, float v2, float v3);
+    void lit(const chunk_neighborhood& nb, int x, int y, float v1, float v2, float v3);
     ldata_ at(int x, int y);
     ldata_ at_stably(int x, int y);
     float get_block_shed(chunk* chunk, int x, int y, int pipe);
     float get_sky_shed(chunk* chunk, int x, int y, int pipe);
-    void spread(int x, int y);
+    void spread(const chunk_neighborhood& nb, int x, int y);
     void render_meshes(const quad& cam);
 };
 
@@ -1,10 +1,16 @@
 #include "render/liquid_model.h"
 
+#include <utility>
+
 #include "chunk_model.h"
+#include "core/def.h"
 #include "core/math.h"
 #include "core/time.h"
+#include "gfx/buffer.h"
+#include "gfx/shader.h"
 #include "render/chunk_model.h"
 #include "world/block.h"
+#include "world/chunknb.h"
 #include "world/liquid.h"
 
 namespace arc {
@@ -12,15 +18,97 @@ namespace arc {
 const int LP = 8;
 const double LP_D = 8.0;
 
-void liquid_model::default_make_liquid_(brush* brush, liquid_model* self, dimension* dim, const liquid_stack& qstack,
-                                        const pos2d& pos) {
+static const std::string dvert_liquid_ =
+    "#version 330 core\n"
+    "layout(location = 0) in vec2 i_position;\n"
+    "layout(location = 1) in vec4 i_color;\n"
+    "layout(location = 2) in vec2 i_texCoord;\n"
+    "layout(location = 3) in vec2 i_flow;\n"
+    "layout(location = 4) in float i_wave;\n"
+    "out vec4 o_color;\n"
+    "out vec2 o_texCoord;\n"
+    "uniform mat4 u_proj;\n"
+    "uniform float u_time;\n"
+    "void main() {\n"
+    "    o_color = i_color;\n"
+    "    o_texCoord = i_texCoord + i_flow * u_time;\n"
+    "    float w = 0.025 * sin(i_position.x * 0.5 + i_position.y * 0.05 + u_time * 3.0);\n"
+    "    gl_Position = u_proj * vec4(i_position.x, i_position.y - i_wave * w, 0.0, 1.0);\n"
+    "}";
+
+static const std::string dfrag_liquid_ =
+    "#version 330 core\n"
+    "in vec4 o_color;\n"
+    "in vec2 o_texCoord;\n"
+    "out vec4 fragColor;\n"
+    "uniform sampler2D u_tex;\n"
+    "void main() {\n"
+    "    fragColor = o_color * texture(u_tex, o_texCoord);\n"
+    "}";
+
+static std::shared_ptr<program> liquid_prog_;
+
+std::shared_ptr<program> liquid_model::program_() {
+    if (liquid_prog_ == nullptr) {
+        liquid_prog_ = program::make(dvert_liquid_, dfrag_liquid_, [](program* program) {
+            const int s = ARC_LIQUID_VERTEX_STRIDE;
+            program->get_attrib(0).layout(shader_vertex_data_type::f32, 2, s, 0);
+            program->get_attrib(1).layout(shader_vertex_data_type::u8, 4, s, 8, true);
+            program->get_attrib(2).layout(shader_vertex_data_type::f32, 2, s, 12);
+            program->get_attrib(3).layout(shader_vertex_data_type::f32, 2, s, 20);
+            program->get_attrib(4).layout(shader_vertex_data_type::f32, 1, s, 28);
+
+            if (program->cached_uniforms.size() > 0) return;
+            program->cache_uniform("u_proj");                     // 0
+            program->cache_uniform("u_tex").set_texture_unit(1);  // 1
+            program->cache_uniform("u_time");                     // 2
+        });
+    }
+    return liquid_prog_;
+}
+
+struct liquid_vertex_ {
+    float x, y;
+    uint32_t col;
+    float u, v, fu, fv, wave;
+};
+
+static_assert(sizeof(liquid_vertex_) == ARC_LIQUID_VERTEX_STRIDE, "liquid vertices must match the stride.");
+
+// same corners and uv mapping as brush#draw_texture, plus the flow (uv per second) and the wave weight of the top
+// and bottom edges.
+static void write_quad_(complex_buffer* buf, const std::shared_ptr<texture>& tex, const quad& dst, const quad& src,
+                        float fu, float fv, float wave_top, float wave_bottom) {
+    float u = (src.x + tex->u) / tex->full_width;
+    float v = (src.y + tex->v) / tex->full_height;
+    float u2 = (src.prom_x() + tex->u) / tex->full_width;
+    float v2 = (src.prom_y() + tex->v) / tex->full_height;
+#ifdef ARC_Y_IS_DOWN
+    if (!tex->is_framebuffer_) std::swap(v, v2);
+#else
+    if (tex->is_framebuffer_) std::swap(v, v2);
+#endif
+
+    float x1 = dst.x, y1 = dst.y, x2 = dst.prom_x(), y2 = dst.prom_y();
+    const uint32_t white = 0xFFFFFFFF;
+
+    liquid_vertex_* vs = buf->push_vertices<liquid_vertex_>(4);
+    vs[0] = {x2, y2, white, u2, v, fu, fv, wave_bottom};
+    vs[1] = {x2, y1, white, u2, v2, fu, fv, wave_top};
+    vs[2] = {x1, y1, white, u, v2, fu, fv, wave_top};
+    vs[3] = {x1, y2, white, u, v, fu, fv, wave_bottom};
+    buf->end_quad();
+}
+
+void liquid_model::default_make_liquid_(brush* brush, liquid_model* self, dimension* dim,
+                                        const chunk_neighborhood& nb, const liquid_stack& qstack, const pos2d& pos) {
     if (qstack.is_empty()) return;
 
     int x = pos.x;
     int y = pos.y;
 
-    block_behavior* bu = fast_get_block(x, y - 1);
-    liquid_stack qstacku = fast_get_liquid_stack(x, y - 1);
+    block_behavior* bu = nb.find_block(x, y - 1);
+    liquid_stack qstacku = nb.find_liquid_stack(x, y - 1);
 
     double p = qstack.percentage();
     double s = clock::now().seconds;
@@ -37,4 +125,33 @@ void liquid_model::default_make_liquid_(brush* brush, liquid_model* self, dimens
         brush->draw_texture(self->tex_edge, quad(x, y + (1.0 - h), 1.0, 1.0 / LP_D), quad(u, 0, LP_D, 1.0));
 }
 
+void liquid_model::default_cache_liquid_(
+    const std::function<complex_buffer*(const std::shared_ptr<texture>&)>& buffer_of, liquid_model* self,
+    const chunk_neighborhood& nb, const liquid_stack& qstack, const pos2i& pos) {
+    if (qstack.is_empty() || self->tex == nullptr) return;
+
+    int x = pos.x;
+    int y = pos.y;
+
+    block_behavior* bu = nb.find_block(x, y - 1);
+    liquid_stack qstacku = nb.find_liquid_stack(x, y - 1);
+
+    double h = qstack.percentage();
+    bool surface = qstacku.is_empty() && (h < 1.0 || !bu->shape.solid);
+    float wave = surface ? 1.0f : 0.0f;
+
+    // pixels per second in the old per-frame path, normalized to the texture here.
+    float fu = 2.0 * self->flow_speed / self->tex->full_width;
+    float fv = 0.5 * self->flow_speed / self->tex->full_height;
+
+    write_quad_(buffer_of(self->tex), self->tex, quad(x, y + (1.0 - h), 1.0, h),
+                quad(x * LP_D, y * LP_D + LP_D * (1.0 - h), LP_D, LP_D * h), fu, fv, wave, 0.0f);
+
+    if (surface && self->tex_edge != nullptr) {
+        float fue = 2.0 * self->flow_speed / self->tex_edge->full_width;
+        write_quad_(buffer_of(self->tex_edge), self->tex_edge, quad(x, y + (1.0 - h), 1.0, 1.0 / LP_D),
+                    quad(0, 0, LP_D, 1.0), fue, 0.0f, wave, wave);
+    }
+}
+
 }  // namespace arc
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include <cstdint>
+#include <functional>
 #include <memory>
 
 #include "gfx/brush.h"
@@ -7,18 +8,35 @@
 #include "world/block.h"
 #include "world/liquid.h"
 
+// vertex stride of cached liquid meshes: f32 pos * 2, u8 color * 4, f32 uv * 2, f32 flow * 2, f32 wave.
+#define ARC_LIQUID_VERTEX_STRIDE 32
+
 namespace arc {
 
+struct chunk_neighborhood;
+struct complex_buffer;
+struct program;
+
 struct liquid_model {
     ARC_REGISTERABLE
-    void (*make_liquid)(brush* brush, liquid_model* self, dimension* dim, const liquid_stack& qstack,
-                        const pos2d& pos) = default_make_liquid_;
+    void (*make_liquid)(brush* brush, liquid_model* self, dimension* dim, const chunk_neighborhood& nb,
+                        const liquid_stack& qstack, const pos2d& pos) = default_make_liquid_;
     std::shared_ptr<texture> tex = nullptr;
     std::shared_ptr<texture> tex_edge = nullptr;
     double flow_speed = 1.0;
+    // draw the liquid every frame through #make_liquid instead of the cached chunk mesh.
+    // set it when #make_liquid is replaced, cached meshes are always written by #default_cache_liquid_.
+    bool dynamic_render = false;
 
-    static void default_make_liquid_(brush* brush, liquid_model* self, dimension* dim, const liquid_stack& qstack,
-                                     const pos2d& pos);
+    static void default_make_liquid_(brush* brush, liquid_model* self, dimension* dim, const chunk_neighborhood& nb,
+                                     const liquid_stack& qstack, const pos2d& pos);
+    // write a cell into the cached liquid mesh of a chunk. #buffer_of gives the buffer of a texture.
+    // the surface wave and the uv flow are not baked, the liquid program animates them with u_time.
+    static void default_cache_liquid_(const std::function<complex_buffer*(const std::shared_ptr<texture>&)>& buffer_of,
+                                      liquid_model* self, const chunk_neighborhood& nb, const liquid_stack& qstack,
+                                      const pos2i& pos);
+    // the program cached liquid meshes are drawn with.
+    static std::shared_ptr<program> program_();
 };
 
 }  // namespace arc
\ No newline at end of file
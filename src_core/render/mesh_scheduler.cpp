@@ -0,0 +1,98 @@
+#include "render/mesh_scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "core/thrp.h"
+#include "render/chunk_model.h"
+#include "world/chunk.h"
+#include "world/chunknb.h"
+#include "world/dim.h"
+
+namespace arc {
+
+struct rebuild_job_ {
+    pos2i pos;
+    chunk* chunk_;
+    bool visible;
+    double dist;
+};
+
+static bool cmp_rebuild_job_(const rebuild_job_& j1, const rebuild_job_& j2) {
+    if (j1.visible != j2.visible) return j1.visible;
+    return j1.dist < j2.dist;
+}
+
+void mesh_scheduler::init(dimension* dim) { this->dim = dim; }
+
+void mesh_scheduler::mark(chunk* chunk_, uint8_t layers) {
+    chunk_model* model = chunk_->model;
+    model->dirty_layers |= layers;
+    if (model->queued_.exchange(true)) return;
+
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    queue_.push_back(chunk_->pos);
+}
+
+void mesh_scheduler::run(const quad& cam) {
+    std::vector<pos2i> pending;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        std::swap(pending, queue_);
+    }
+    if (pending.empty()) return;
+
+    std::vector<rebuild_job_> jobs;
+    std::vector<pos2i> carried;
+    jobs.reserve(pending.size());
+
+    for (auto& pos : pending) {
+        obs<chunk> chunk_ = dim->find_chunk(pos);
+        if (!chunk_) {
+            // not active yet, dropped until dimension#set_chunk queues it again. its dirty layers are kept.
+            obs<chunk> cached = dim->find_chunk(pos, find_chunk_flag::cache);
+            if (!cached || !cached->model) continue;
+            cached->model->queued_ = false;
+            // activated in between, its set_chunk saw it still queued.
+            if (dim->find_chunk(pos)) mark(cached.get(), 0);
+            continue;
+        }
+        quad box = quad(chunk_->min_x, chunk_->min_y, ARC_CHUNK_SIZE, ARC_CHUNK_SIZE);
+        double dx = box.center_x() - cam.center_x();
+        double dy = box.center_y() - cam.center_y();
+        jobs.push_back({pos, chunk_.get(), quad::intersect(box, cam), dx * dx + dy * dy});
+    }
+
+    std::sort(jobs.begin(), jobs.end(), cmp_rebuild_job_);
+
+    auto start = std::chrono::steady_clock::now();
+    size_t i = 0;
+    for (; i < jobs.size(); i++) {
+        double spent = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        if (i > 0 && spent >= budget_us) break;
+
+        chunk_model* model = jobs[i].chunk_->model;
+        // unqueue before taking the bits, so a mark during the rebuild queues the chunk again.
+        model->queued_ = false;
+        uint8_t layers = model->dirty_layers.exchange(0);
+        // gathered here on the main thread, the build itself only reads the snapshot.
+        auto nb = std::make_shared<chunk_neighborhood>(chunk_neighborhood::around(dim, jobs[i].pos));
+
+        for (int l = 0; l < ARC_CHUNK_MESH_LAYER_COUNT; l++) {
+            if (!(layers & (1 << l))) continue;
+#ifdef ARC_MULTITHREADED_MESH_BUILD
+            thread_pool::execute([model, l, nb]() { model->instant_rebuild(l, *nb); });
+#else
+            model->instant_rebuild(l, *nb);
+#endif
+        }
+    }
+
+    for (; i < jobs.size(); i++) carried.push_back(jobs[i].pos);
+
+    if (carried.empty()) return;
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    queue_.insert(queue_.end(), carried.begin(), carried.end());
+}
+
+}  // namespace arc
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "core/math.h"
+#include "world/pos.h"
+
+// time spent on rebuilding chunk meshes per frame, in microseconds.
+// at least one chunk is rebuilt every frame, so a tiny budget never stalls the queue.
+#define ARC_MESH_REBUILD_BUDGET_US 2000
+
+namespace arc {
+
+struct dimension;
+struct chunk;
+
+struct mesh_scheduler {
+    dimension* dim = nullptr;
+    double budget_us = ARC_MESH_REBUILD_BUDGET_US;
+    std::mutex queue_mutex_;
+    std::vector<pos2i> queue_;
+
+    void init(dimension* dim);
+    // mark the layers (bits of chunk_mesh_layer) of a chunk dirty.
+    // repeated marks before the chunk is rebuilt are merged.
+    void mark(chunk* chunk_, uint8_t layers);
+    // rebuild dirty chunks, visible and nearest ones first, until the budget is spent.
+    // the rest is carried over to the next frame. chunks only in the cache are dropped until dimension#set_chunk.
+    void run(const quad& cam);
+};
+
+}  // namespace arc
@@ -0,0 +1,173 @@
+#include "render/region_model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "gfx/brush.h"
+#include "gfx/mesh.h"
+#include "render/chunk_model.h"
+#include "world/chunk.h"
+#include "world/dim.h"
+
+namespace arc {
+
+static int region_of_(int c) { return c >= 0 ? c / ARC_REGION_SIZE : (c + 1) / ARC_REGION_SIZE - 1; }
+
+static bool same_state_(const graph_state& s1, const graph_state& s2) {
+    unsigned int t1 = s1.texture == nullptr ? 0 : s1.texture->texture_id_;
+    unsigned int t2 = s2.texture == nullptr ? 0 : s2.texture->texture_id_;
+    return s1.mode == s2.mode && s1.prog == s2.prog && t1 == t2 && s1.format == s2.format;
+}
+
+static int group_for_(region_layer_& rl, const graph_state& state) {
+    for (int i = 0; i < rl.used; i++)
+        if (same_state_(rl.meshes[i]->state, state)) return i;
+
+    if (rl.used == static_cast<int>(rl.meshes.size())) rl.meshes.push_back(mesh::make());
+    mesh* msh = rl.meshes[rl.used].get();
+    msh->buffer->clear();
+    msh->state = state;
+    return rl.used++;
+}
+
+void region_model::init(const pos2i& pos) {
+    this->pos = pos;
+    layers.resize(ARC_CHUNK_MESH_LAYER_COUNT);
+}
+
+vec2 region_model::origin_of(const pos2i& chunk_pos) {
+    const int span = ARC_REGION_SIZE * ARC_CHUNK_SIZE;
+    return vec2(region_of_(chunk_pos.x) * span, region_of_(chunk_pos.y) * span);
+}
+
+bool region_model::patch_member_(int layer, int k) {
+    region_layer_& rl = layers[layer];
+    mesh* src = rl.members[k]->model->meshes_used[layer].get();
+    // rebuilt (the double buffer swapped), resized or moved to another texture, the offsets do not hold.
+    if (src != rl.sources[k] || src->buffer->vertex_buf.size() != rl.sizes[k]) return false;
+    if (rl.sizes[k] == 0) return true;
+    if (!same_state_(rl.meshes[rl.groups[k]]->state, src->state)) return false;
+
+    complex_buffer* dst = rl.meshes[rl.groups[k]]->buffer.get();
+    const uint8_t* from = src->buffer->vertex_buf.data();
+    uint8_t* to = dst->vertex_buf.data() + rl.offsets[k];
+    size_t n = rl.sizes[k];
+
+    // only the bytes that differ are copied and marked, usually the quads of one cell.
+    size_t lo = std::mismatch(from, from + n, to).first - from;
+    if (lo == n) return true;
+    size_t hi = n;
+    while (hi > lo && from[hi - 1] == to[hi - 1]) hi--;
+    std::memcpy(to + lo, from + lo, hi - lo);
+    dst->mark_dirty_(rl.offsets[k] + lo, rl.offsets[k] + hi);
+    return true;
+}
+
+bool region_model::refresh(dimension* dim, int layer) {
+    region_layer_& rl = layers[layer];
+    bool changed = !rl.merged;
+    bool empty = true;
+    uint32_t patched = 0;
+
+    for (int k = 0; k < ARC_REGION_SIZE * ARC_REGION_SIZE; k++) {
+        int cx = pos.x * ARC_REGION_SIZE + k % ARC_REGION_SIZE;
+        int cy = pos.y * ARC_REGION_SIZE + k / ARC_REGION_SIZE;
+        chunk* chunk_ = dim->find_chunk(pos2i(cx, cy));
+        uint32_t version = chunk_ ? chunk_->model->mesh_version[layer].load() : 0;
+        if (chunk_) empty = false;
+        if (chunk_ != rl.members[k] || (version != rl.versions[k] && rl.versions[k] == 0))
+            changed = true;
+        else if (version != rl.versions[k])
+            patched |= 1U << k;
+        rl.members[k] = chunk_;
+        rl.versions[k] = version;
+    }
+
+    if (!changed) {
+        for (int k = 0; k < ARC_REGION_SIZE * ARC_REGION_SIZE && !changed; k++)
+            if ((patched >> k & 1) && !patch_member_(layer, k)) changed = true;
+        if (!changed) return !empty;
+    }
+
+    // members keep the row order, the result does not depend on which chunk was rebuilt last.
+    rl.used = 0;
+    for (int k = 0; k < ARC_REGION_SIZE * ARC_REGION_SIZE; k++) {
+        rl.sources[k] = nullptr;
+        rl.sizes[k] = 0;
+        if (rl.members[k] == nullptr || rl.versions[k] == 0) continue;
+        mesh* src = rl.members[k]->model->meshes_used[layer].get();
+        rl.sources[k] = src;
+        if (src->buffer->vertex_count == 0) continue;
+        int g = group_for_(rl, src->state);
+        complex_buffer* dst = rl.meshes[g]->buffer.get();
+        rl.groups[k] = g;
+        rl.offsets[k] = dst->vertex_buf.size();
+        rl.sizes[k] = src->buffer->vertex_buf.size();
+        dst->append(*src->buffer);
+    }
+    rl.merged = true;
+    return !empty;
+}
+
+void region_model::render(brush* brush, int layer) {
+    region_layer_& rl = layers[layer];
+    for (int i = 0; i < rl.used; i++) rl.meshes[i]->draw(brush);
+}
+
+void region_renderer::init(dimension* dim) { this->dim = dim; }
+
+void region_renderer::render(brush* brush, int layer, const quad& cam) {
+    int rx0 = region_of_(findc(std::round(cam.x - 1)));
+    int ry0 = region_of_(findc(std::round(cam.y - 1)));
+    int rx1 = region_of_(findc(std::round(cam.prom_x() + 1)));
+    int ry1 = region_of_(findc(std::round(cam.prom_y() + 1)));
+
+    for (int rx = rx0; rx <= rx1; rx++) {
+        for (int ry = ry0; ry <= ry1; ry++) {
+            pos2i rpos = pos2i(rx, ry);
+            auto it = regions.find(rpos);
+            if (it == regions.end()) {
+                auto region = std::make_unique<region_model>();
+                region->init(rpos);
+                it = regions.emplace(rpos, std::move(region)).first;
+            }
+            if (!it->second->refresh(dim, layer)) {
+                regions.erase(it);
+                continue;
+            }
+            it->second->render(brush, layer);
+        }
+    }
+}
+
+void region_renderer::replay(brush* brush, int layer, const quad& cam) const {
+    int rx0 = region_of_(findc(std::round(cam.x - 1)));
+    int ry0 = region_of_(findc(std::round(cam.y - 1)));
+    int rx1 = region_of_(findc(std::round(cam.prom_x() + 1)));
+    int ry1 = region_of_(findc(std::round(cam.prom_y() + 1)));
+
+    for (int rx = rx0; rx <= rx1; rx++) {
+        for (int ry = ry0; ry <= ry1; ry++) {
+            auto it = regions.find(pos2i(rx, ry));
+            if (it != regions.end()) it->second->render(brush, layer);
+        }
+    }
+}
+
+void region_renderer::prune() {
+    if (seen_chunks_ == dim->chunk_map.size()) return;
+    seen_chunks_ = dim->chunk_map.size();
+
+    for (auto it = regions.begin(); it != regions.end();) {
+        bool empty = true;
+        for (int k = 0; k < ARC_REGION_SIZE * ARC_REGION_SIZE && empty; k++) {
+            int cx = it->first.x * ARC_REGION_SIZE + k % ARC_REGION_SIZE;
+            int cy = it->first.y * ARC_REGION_SIZE + k / ARC_REGION_SIZE;
+            if (dim->find_chunk(pos2i(cx, cy))) empty = false;
+        }
+        it = empty ? regions.erase(it) : std::next(it);
+    }
+}
+
+}  // namespace arc
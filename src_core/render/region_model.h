@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "core/math.h"
+#include "world/pos.h"
+
+// chunks per side of a region. the static meshes of a region layer are merged, one draw per texture.
+#define ARC_REGION_SIZE 4
+
+namespace arc {
+
+struct dimension;
+struct brush;
+struct mesh;
+struct chunk;
+
+struct region_layer_ {
+    // one merged mesh per graph state found in the members, only the first #used are valid.
+    std::vector<std::shared_ptr<mesh>> meshes;
+    int used = 0;
+    // the members and their mesh versions at the last merge.
+    chunk* members[ARC_REGION_SIZE * ARC_REGION_SIZE] = {nullptr};
+    uint32_t versions[ARC_REGION_SIZE * ARC_REGION_SIZE] = {0};
+    // where each member went at the last merge: its mesh, the merged mesh index, and its byte range in there.
+    // a patched member keeps its mesh and size, so only its range is written again.
+    mesh* sources[ARC_REGION_SIZE * ARC_REGION_SIZE] = {nullptr};
+    int groups[ARC_REGION_SIZE * ARC_REGION_SIZE] = {0};
+    size_t offsets[ARC_REGION_SIZE * ARC_REGION_SIZE] = {0};
+    size_t sizes[ARC_REGION_SIZE * ARC_REGION_SIZE] = {0};
+    bool merged = false;
+};
+
+struct region_model {
+    pos2i pos;
+    std::vector<region_layer_> layers;
+
+    void init(const pos2i& pos);
+    // the point compact chunk meshes of a region are relative to, so that merging them needs no rewrite.
+    static vec2 origin_of(const pos2i& chunk_pos);
+    // merge the layer again if a member was loaded, unloaded or rebuilt, patched members are copied in place.
+    // returns false if the region is empty.
+    bool refresh(dimension* dim, int layer);
+    bool patch_member_(int layer, int k);
+    void render(brush* brush, int layer);
+};
+
+struct region_renderer {
+    dimension* dim = nullptr;
+    std::unordered_map<pos2i, std::unique_ptr<region_model>> regions;
+    size_t seen_chunks_ = 0;
+
+    void init(dimension* dim);
+    // draw the static meshes of a chunk layer for every region touching the camera.
+    // dynamic blocks are not in there, see chunk_model#render_unmeshed.
+    void render(brush* brush, int layer, const quad& cam);
+    // draw the regions already merged under the camera as they are, nothing is created, refreshed or dropped.
+    void replay(brush* brush, int layer, const quad& cam) const;
+    // drop regions whose chunks are all unloaded.
+    void prune();
+};
+
+}  // namespace arc
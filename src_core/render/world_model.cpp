@@ -1,11 +1,17 @@
 #include "render/world_model.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include "gfx/device.h"
 #include "gfx/fbuf.h"
 #include "gfx/shader.h"
 #include "render/chunk_model.h"
 #include "render/liquid_model.h"
+#include "render/mesh_scheduler.h"
+#include "render/region_model.h"
 #include "world/chunk.h"
+#include "world/chunknb.h"
 #include "world/dimh.h"
 #include "world/liquid.h"
 
@@ -64,53 +70,103 @@ void wrd::retry() {
     }
 }
 
-void wrd::render(brush* brush, dimension* dim, const quad& cam) {
+static chunk_view view_;
+
+static bool cmp_visible_(const std::pair<double, chunk*>& c1, const std::pair<double, chunk*>& c2) {
+    return c1.first < c2.first;
+}
+
+const chunk_view& wrd::collect(dimension* dim, const quad& cam) {
+    static std::vector<std::pair<double, chunk*>> sorted_;
+    view_.cam = cam;
+    view_.nb = std::make_shared<chunk_neighborhood>(chunk_neighborhood::covering(dim, cam, ARC_RENDER_VIEW_MARGIN));
+
     int cy0 = std::round(cam.y - 1);
     int cy1 = std::round(cam.prom_y() + 1);
     int cx0 = std::round(cam.x - 1);
     int cx1 = std::round(cam.prom_x() + 1);
 
-    // chunk layer render macro
-#define ARC_RCLVL_(layer)                                                                                       \
-    for (auto& kv : dim->chunk_map) {                                                                           \
-        auto& chunk_ = kv.second;                                                                               \
-        if (chunk_->min_x > cx1 || chunk_->min_y > cy1 || chunk_->max_x < cx0 || chunk_->max_y < cy0) continue; \
-        if (chunk_->model->built[static_cast<int>(layer)]) chunk_->model->render(brush, layer);                 \
+    // walk the grid cells under the view, not the whole chunk map.
+    sorted_.clear();
+    for (int x = findc(cx0); x <= findc(cx1); x++) {
+        for (int y = findc(cy0); y <= findc(cy1); y++) {
+            chunk* chunk_ = view_.nb->find_chunk(x * ARC_CHUNK_SIZE, y * ARC_CHUNK_SIZE);
+            if (chunk_ == nullptr) continue;
+            double dx = chunk_->min_x + ARC_CHUNK_SIZE / 2.0 - cam.center_x();
+            double dy = chunk_->min_y + ARC_CHUNK_SIZE / 2.0 - cam.center_y();
+            sorted_.emplace_back(dx * dx + dy * dy, chunk_);
+        }
     }
+    std::sort(sorted_.begin(), sorted_.end(), cmp_visible_);
+
+    view_.visible.clear();
+    for (auto& kv : sorted_) view_.visible.push_back(kv.second);
+    return view_;
+}
+
+const chunk_view& wrd::last_view() { return view_; }
+
+// the draw sequence of a collected view, shared by #render and #replay.
+// a live frame draws into the world framebuffers and rebuilds dirty region and liquid meshes,
+// a replay draws straight to #brush with the meshes as they are.
+static void draw_view_(brush* brush, dimension* dim, const chunk_view& view, bool live) {
+    const quad& cam = view.cam;
+    const chunk_neighborhood& nb = *view.nb;
+
+    // chunk layer render macro
+#define ARC_RCLVL_(layer)                                                  \
+    if (live)                                                              \
+        dim->region_executor->render(brush, static_cast<int>(layer), cam); \
+    else                                                                   \
+        dim->region_executor->replay(brush, static_cast<int>(layer), cam); \
+    for (chunk* chunk_ : view.visible) chunk_->model->render_unmeshed(brush, layer, nb);
     // end
 
-    fb_world_back_->retry(brush);
+    if (live) fb_world_back_->retry(brush);
     ARC_RCLVL_(chunk_mesh_layer::back_block);
     ARC_RCLVL_(chunk_mesh_layer::back_block_border);
-    fb_world_back_->record(brush);
-    fb_world_front_->retry(brush);
+    if (live) fb_world_back_->record(brush);
+    if (live) fb_world_front_->retry(brush);
     ARC_RCLVL_(chunk_mesh_layer::furniture);
 
-    // entity rendering
+    // entity rendering, on the thread that owns the grid, so it uses the broadphase.
     quad box_find = cam;
     box_find.inflate(ARC_RENDER_ENTITY_FIND, ARC_RENDER_ENTITY_FIND);
     const auto& found = dim_util::get_intersected_entities(dim, box_find);
 
+    brush->cq_begin();
     for (auto& e : found) {
         // todo
         brush->draw_rect_outline(e->lerped_box_());
     }
+    brush->cq_end();
+
+    // particle rendering, one run per texture page.
+    dim->particles.render(brush, box_find);
 
     // liquid rendering
-    for (auto& kv : dim->chunk_map) {
-        auto& chunk_ = kv.second;
-        if (chunk_->min_x > cx1 || chunk_->min_y > cy1 || chunk_->max_x < cx0 || chunk_->max_y < cy0) continue;
-        scan_cxc(chunk_.get(), [&](const pos2i& pos) {
-            liquid_stack qstack = chunk_->find_liquid_stack(pos);
-            if (!qstack.is_empty())
-                qstack.liquid->model->make_liquid(brush, qstack.liquid->model, dim, qstack, static_cast<pos2d>(pos));
-        });
+    for (chunk* chunk_ : view.visible) {
+        if (live)
+            chunk_->model->render_liquid(brush, nb);
+        else
+            chunk_->model->draw_liquid(brush, nb);
     }
 
     ARC_RCLVL_(chunk_mesh_layer::block);
     ARC_RCLVL_(chunk_mesh_layer::block_border);
     ARC_RCLVL_(chunk_mesh_layer::overlay);
-    fb_world_back_->record(brush);
+    if (live) fb_world_back_->record(brush);
+}
+
+void wrd::render(brush* brush, dimension* dim, const quad& cam) {
+    dim->mesh_executor->run(cam);
+    dim->region_executor->prune();
+    draw_view_(brush, dim, collect(dim, cam), true);
+}
+
+void wrd::replay(brush* brush, dimension* dim) {
+    if (view_.nb == nullptr) return;
+    draw_view_(brush, dim, view_, false);
 }
 
 void wrd::submit(brush* brush, dimension* dim) {
@@ -1,17 +1,40 @@
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include "gfx/brush.h"
+#include "world/chunknb.h"
 #include "world/dim.h"
 
 #define ARC_RENDER_ENTITY_FIND 8
+// blocks around the view whose chunks are collected with it, enough for entity lookups and the light pass.
+#define ARC_RENDER_VIEW_MARGIN 12
 
 namespace arc {
 
+// the chunks of a view, collected once per frame from the chunk grid.
+struct chunk_view {
+    quad cam;
+    // the loaded chunks within the margin around the view.
+    std::shared_ptr<chunk_neighborhood> nb;
+    // the loaded chunks intersecting the view, nearest to its center first.
+    // every layer of a 2d view has the same order, so one list serves all passes.
+    std::vector<chunk*> visible;
+};
+
 namespace wrd {
 
 void retry();
+// collect the chunks of a view for this frame. #render does it itself.
+const chunk_view& collect(dimension* dim, const quad& cam);
+// the view of the last collected frame. its #nb is nullptr before the first one.
+const chunk_view& last_view();
 void render(brush* brush, dimension* dim, const quad& cam);
 void submit(brush* brush, dimension* dim);
+// draw the last collected view again straight to #brush, without the world framebuffers.
+// nothing is meshed, merged, collected or pruned, so the live frame is left as it was.
+void replay(brush* brush, dimension* dim);
 
 }  // namespace wrd
 
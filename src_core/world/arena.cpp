@@ -0,0 +1,56 @@
+#include "world/arena.h"
+
+namespace arc {
+
+bool entity_pool_::fits(size_t bytes, size_t align) {
+    if (align > alignof(std::max_align_t)) return false;
+    size_t sz = (bytes + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+    if (block == 0) block = sz;
+    return block == sz;
+}
+
+void* entity_pool_::take() {
+    if (free_blocks.empty()) {
+        size_t bytes = block * ARC_ENTITY_POOL_PAGE;
+        pages.emplace_back(new std::max_align_t[(bytes + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t)]);
+        auto* base = reinterpret_cast<uint8_t*>(pages.back().get());
+        // handed out from the front of the page.
+        for (int i = ARC_ENTITY_POOL_PAGE - 1; i >= 0; i--) free_blocks.push_back(base + i * block);
+    }
+    void* p = free_blocks.back();
+    free_blocks.pop_back();
+    return p;
+}
+
+std::shared_ptr<entity> entity_arena::make() {
+    return std::allocate_shared<entity>(entity_alloc_<entity>(pool_));
+}
+
+entity_handle entity_arena::add(std::shared_ptr<entity> e) {
+    uint32_t idx;
+    if (!free_slots.empty()) {
+        idx = free_slots.back();
+        free_slots.pop_back();
+    } else {
+        idx = static_cast<uint32_t>(slots.size());
+        slots.emplace_back();
+    }
+
+    slot& s = slots[idx];
+    s.owner = std::move(e);
+    s.owner->handle = {idx, s.gen};
+    return s.owner->handle;
+}
+
+void entity_arena::release(entity_handle h) {
+    if (h.index >= slots.size() || slots[h.index].gen != h.gen) return;
+
+    slot& s = slots[h.index];
+    // moved out first, the destructor of the entity must not see a half-released slot.
+    std::shared_ptr<entity> owner = std::move(s.owner);
+    owner->handle = entity_handle();
+    s.gen++;
+    free_slots.push_back(h.index);
+}
+
+}  // namespace arc
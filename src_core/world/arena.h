@@ -0,0 +1,98 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "world/entity.h"
+
+// blocks in one page of the entity pool.
+#define ARC_ENTITY_POOL_PAGE 256
+
+namespace arc {
+
+// fixed-size blocks for the entities of one dimension, a freed block is reused first.
+// the block size is taken from the first allocation, other sizes go to the heap.
+struct entity_pool_ {
+    size_t block = 0;
+    std::vector<std::unique_ptr<std::max_align_t[]>> pages;
+    std::vector<void*> free_blocks;
+
+    bool fits(size_t bytes, size_t align);
+    void* take();
+    void give(void* p) { free_blocks.push_back(p); }
+};
+
+// allocates the shared block of an entity (control block and object) from the pool.
+// copies share the pool, so it lives until the last entity made from it is gone.
+template <typename T>
+struct entity_alloc_ {
+    using value_type = T;
+    std::shared_ptr<entity_pool_> pool;
+
+    explicit entity_alloc_(std::shared_ptr<entity_pool_> pool) : pool(std::move(pool)) {}
+    template <typename U>
+    entity_alloc_(const entity_alloc_<U>& o) : pool(o.pool) {}
+
+    T* allocate(size_t n) {
+        if (n == 1 && pool->fits(sizeof(T), alignof(T))) return static_cast<T*>(pool->take());
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n) {
+        if (n == 1 && pool->fits(sizeof(T), alignof(T)))
+            pool->give(p);
+        else
+            ::operator delete(p);
+    }
+
+    template <typename U>
+    bool operator==(const entity_alloc_<U>& o) const {
+        return pool == o.pool;
+    }
+    template <typename U>
+    bool operator!=(const entity_alloc_<U>& o) const {
+        return pool != o.pool;
+    }
+};
+
+// the entities of a dimension in stable slots, addressed by entity_handle.
+// a freed slot is reused with the next generation, so old handles to it resolve to nullptr.
+struct entity_arena {
+    struct slot {
+        std::shared_ptr<entity> owner;
+        uint32_t gen = 0;
+    };
+
+    std::vector<slot> slots;
+    std::vector<uint32_t> free_slots;
+    std::shared_ptr<entity_pool_> pool_ = std::make_shared<entity_pool_>();
+
+    // a new entity in the pooled memory of this arena, it still has to be spawned.
+    std::shared_ptr<entity> make();
+    // take ownership of #e and give it a handle, e->handle is set.
+    entity_handle add(std::shared_ptr<entity> e);
+    // drop the entity of #h, the entity is destroyed unless someone else still owns it.
+    void release(entity_handle h);
+
+    entity* get(entity_handle h) const {
+        if (h.index >= slots.size() || slots[h.index].gen != h.gen) return nullptr;
+        return slots[h.index].owner.get();
+    }
+
+    // the owning pointer, only for the places that need to keep the entity alive.
+    std::shared_ptr<entity> share(entity_handle h) const {
+        if (h.index >= slots.size() || slots[h.index].gen != h.gen) return nullptr;
+        return slots[h.index].owner;
+    }
+
+    // visit every live entity in slot order.
+    template <typename F>
+    void each(F&& f) {
+        for (slot& s : slots)
+            if (s.owner) f(s.owner.get());
+    }
+};
+
+}  // namespace arc
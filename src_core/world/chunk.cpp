@@ -1,6 +1,5 @@
 #include "world/chunk.h"
 
-#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -33,8 +32,7 @@ void chunk::init(dimension* dim, const pos2i& pos) {
 }
 
 void chunk::tick() {
-    model->tick();
-    tick_entities();
+    // entities are ticked by the dimension, see dimension#tick_entities.
     liquid_flow_engine(obs<chunk>::unsafe_make(this));
 }
 
@@ -48,12 +46,25 @@ void chunk::set_block(block_behavior* block, const pos2i& pos, set_block_flag fl
     auto* ptr = blocks_.find(pos.x, pos.y);
     advance_write_ptr_<uint32_t>(ptr, static_cast<uint32_t>(block->id));
 
+    int bit = mask_bit_(pos.x, pos.y);
+    uint64_t m = 1ULL << (bit & 63);
+    solid_mask_[bit >> 6] &= ~m;
+    shape_mask_[bit >> 6] &= ~m;
+    if (block->voxel_shape)
+        shape_mask_[bit >> 6] |= m;
+    else if (block->shape.solid)
+        solid_mask_[bit >> 6] |= m;
+
+    dim->wake_near(pos);
+
     if (block->shape == block_shape::furniture) {
         model->rebuild(pos, chunk_mesh_layer::furniture);
     } else {
-        model->rebuild(pos, chunk_mesh_layer::block);
-        model->rebuild(pos, chunk_mesh_layer::back_block);
+        model->patch(pos, chunk_mesh_layer::block);
+        model->patch(pos, chunk_mesh_layer::back_block);
     }
+    // the liquid surface under a block depends on it.
+    model->mark_liquid(pos);
 }
 
 block_behavior* chunk::find_back_block(const pos2i& pos) {
@@ -66,7 +77,7 @@ void chunk::set_back_block(block_behavior* block, const pos2i& pos, set_block_fl
     auto* ptr = back_blocks_.find(pos.x, pos.y);
     advance_write_ptr_<uint32_t>(ptr, static_cast<uint32_t>(block->id));
 
-    model->rebuild(pos, chunk_mesh_layer::back_block);
+    model->patch(pos, chunk_mesh_layer::back_block);
     model->ao_rebuild = true;
 }
 
@@ -85,9 +96,15 @@ liquid_stack chunk::find_liquid_stack(const pos2i& pos) {
 }
 
 void chunk::set_liquid_stack(const liquid_stack& s, const pos2i& pos) {
+    liquid_stack old = find_liquid_stack(pos);
     auto* ptr = liquids_.find(pos.x, pos.y);
     advance_write_ptr_<uint32_t>(ptr, static_cast<uint32_t>(s.liquid->id));
     advance_write_ptr_<uint8_t>(ptr, s.amount);
+
+    if (old.liquid != s.liquid || old.amount != s.amount) {
+        model->mark_liquid(pos);
+        dim->wake_near(pos);
+    }
 }
 
 obs<codec_map> chunk::find_place_cdmap(const pos2i& pos) {
@@ -104,56 +121,39 @@ obs<codec_map> chunk::ensure_place_cdmap(const pos2i& pos) {
     return it->second;
 }
 
-void chunk::tick_entities() {
-    for (int i = static_cast<int>(entities.size()) - 1; i >= 0; i--) {
-        if (i >= static_cast<int>(entities.size())) break;
-
-        obs<entity> e = entities[i];
-
-        if (!e) continue;
-        if (dim->ticks == e->wt_anc_) continue;  // tick wrongly invoked. When transferring this happens.
-        e->wt_anc_ = dim->ticks;
-        e->force();
-        e->motion();
-        if (e->tick) e->tick(e);
-
-        if (e->parent == nullptr) e->parent = obs<chunk>::unsafe_make(this);
-
-        const pos2i& oldpos = e->parent->pos;
-        const pos2i& newpos = e->pos.findc();
-        if (oldpos != newpos) {
-            chunk* newc = dim->find_chunk(newpos);
-            if (newc != nullptr) {
-                move_entity(e.lock(), newc);
-            }
-        }
-
-        if (e->is_dead) {
-            remove_entity(e, true);
-        }
+void chunk::remove_entity(entity* e, bool global) {
+    int at = e->chunk_slot_;
+    if (at >= 0 && at < static_cast<int>(entities.size()) && entities[at] == e) {
+        entities[at] = entities.back();
+        entities[at]->chunk_slot_ = at;
+        entities.pop_back();
     }
-}
-
-void chunk::remove_entity(obs<entity> e, bool global) {
-    entities.erase(std::find(entities.begin(), entities.end(), e.lock()));
+    e->chunk_slot_ = -1;
     e->parent = nullptr;
     // remote entities should wait for packets to be removed.
+    // the entity may be destroyed by this, so it is the last use.
     if (global && dim->server) dim->remove_entity(e->uuid);
 }
 
-void chunk::spawn_entity(std::shared_ptr<entity> e) {
+void chunk::spawn_entity(entity* e) {
+    e->chunk_slot_ = static_cast<int>(entities.size());
     entities.push_back(e);
     e->parent = obs<chunk>::unsafe_make(this);
 }
 
-void chunk::move_entity(std::shared_ptr<entity> e, chunk* newc) {
+void chunk::move_entity(entity* e, chunk* newc) {
     remove_entity(e, false);
     newc->spawn_entity(e);
 }
 
 void chunk::clear_entity() {
-    for (auto& e : entities) dim->remove_entity(e->uuid);
-    entities.clear();
+    // removing from the dimension also removes from this list.
+    while (!entities.empty()) {
+        entity* e = entities.back();
+        size_t n = entities.size();
+        dim->remove_entity(e->uuid);
+        if (entities.size() == n) remove_entity(e, false);
+    }
 }
 
 }  // namespace arc
\ No newline at end of file
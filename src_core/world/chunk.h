@@ -32,6 +32,9 @@ struct chunk_storage_ {
     }
 };
 
+// words of a one-bit-per-cell chunk mask.
+#define ARC_CHUNK_MASK_WORDS (ARC_CHUNK_SIZE * ARC_CHUNK_SIZE / 64)
+
 enum class set_block_flag { no = 1 << 0L, silent = 1 << 1L, admin = 1 << 2L };
 
 struct chunk_model;
@@ -43,7 +46,12 @@ struct chunk {
     chunk_storage_<4> biomes_;
     chunk_storage_<4 + 1> liquids_;
 
-    std::vector<std::shared_ptr<entity>> entities;
+    // owned by the arena of the dimension, an entity knows its index here (entity#chunk_slot_).
+    std::vector<entity*> entities;
+    // collision masks, one bit per cell (see #mask_bit_), kept by #set_block.
+    // solid_mask_ marks full cubes, shape_mask_ marks blocks that decide their shape by voxel_shape.
+    uint64_t solid_mask_[ARC_CHUNK_MASK_WORDS] = {};
+    uint64_t shape_mask_[ARC_CHUNK_MASK_WORDS] = {};
     std::unordered_map<pos2i, std::shared_ptr<block_entity>> block_entity_map;
     std::unordered_map<pos2i, std::shared_ptr<codec_map>> place_cdmap_map;
     pos2i pos;
@@ -66,11 +74,20 @@ struct chunk {
     void set_liquid_stack(const liquid_stack& s, const pos2i& pos);
     obs<codec_map> find_place_cdmap(const pos2i& pos);
     obs<codec_map> ensure_place_cdmap(const pos2i& pos);
-    void tick_entities();
-    void remove_entity(obs<entity> e, bool global);
-    void spawn_entity(std::shared_ptr<entity> e);
-    void move_entity(std::shared_ptr<entity> e, chunk* newc);
+    void remove_entity(entity* e, bool global);
+    void spawn_entity(entity* e);
+    void move_entity(entity* e, chunk* newc);
     void clear_entity();
+
+    static int mask_bit_(int x, int y) { return wrap_pos(x) + wrap_pos(y) * ARC_CHUNK_SIZE; }
+    bool is_solid_(int x, int y) const {
+        int b = mask_bit_(x, y);
+        return solid_mask_[b >> 6] >> (b & 63) & 1;
+    }
+    bool is_shaped_(int x, int y) const {
+        int b = mask_bit_(x, y);
+        return shape_mask_[b >> 6] >> (b & 63) & 1;
+    }
 };
 
 template <typename F>
@@ -0,0 +1,65 @@
+#include "world/chunknb.h"
+
+#include <cmath>
+
+#include "ctt.h"
+#include "world/block.h"
+#include "world/chunk.h"
+#include "world/dim.h"
+
+namespace arc {
+
+chunk* chunk_neighborhood::find_chunk(int x, int y) const {
+    int i = findc(x) - origin.x;
+    int j = findc(y) - origin.y;
+    if (i < 0 || i >= width || j < 0 || j >= height) return nullptr;
+    return chunks[i + j * width].get();
+}
+
+block_behavior* chunk_neighborhood::find_block(int x, int y) const {
+    chunk* chunk_ = find_chunk(x, y);
+    return chunk_ ? chunk_->find_block({x, y}) : block_void;
+}
+
+block_behavior* chunk_neighborhood::find_back_block(int x, int y) const {
+    chunk* chunk_ = find_chunk(x, y);
+    return chunk_ ? chunk_->find_back_block({x, y}) : block_void;
+}
+
+liquid_stack chunk_neighborhood::find_liquid_stack(int x, int y) const {
+    chunk* chunk_ = find_chunk(x, y);
+    return chunk_ ? chunk_->find_liquid_stack({x, y}) : liquid_stack(liquid_void, 0);
+}
+
+bool chunk_neighborhood::covers(const quad& area) const {
+    return findc(area.x) >= origin.x && findc(area.y) >= origin.y && findc(area.prom_x()) < origin.x + width &&
+           findc(area.prom_y()) < origin.y + height;
+}
+
+chunk_neighborhood chunk_neighborhood::make(dimension* dim, const pos2i& from, const pos2i& to) {
+    chunk_neighborhood nb;
+    nb.origin = from;
+    nb.width = std::max(0, to.x - from.x + 1);
+    nb.height = std::max(0, to.y - from.y + 1);
+    nb.chunks.resize(nb.width * nb.height);
+
+    for (int j = 0; j < nb.height; j++) {
+        for (int i = 0; i < nb.width; i++) {
+            auto it = dim->chunk_map.find(pos2i(from.x + i, from.y + j));
+            if (it != dim->chunk_map.end()) nb.chunks[i + j * nb.width] = it->second;
+        }
+    }
+    return nb;
+}
+
+chunk_neighborhood chunk_neighborhood::around(dimension* dim, const pos2i& cpos, int radius) {
+    return make(dim, pos2i(cpos.x - radius, cpos.y - radius), pos2i(cpos.x + radius, cpos.y + radius));
+}
+
+chunk_neighborhood chunk_neighborhood::covering(dimension* dim, const quad& area, double margin) {
+    pos2i from = pos2i(findc(area.x - margin), findc(area.y - margin));
+    pos2i to = pos2i(findc(area.prom_x() + margin), findc(area.prom_y() + margin));
+    return make(dim, from, to);
+}
+
+}  // namespace arc
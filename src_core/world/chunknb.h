@@ -0,0 +1,42 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+#include "core/math.h"
+#include "world/liquid.h"
+#include "world/pos.h"
+
+namespace arc {
+
+struct chunk;
+struct dimension;
+struct block_behavior;
+
+// a snapshot of the chunks in a rectangle, built for one job (a mesh build, a light pass, a render view).
+// it keeps the chunks alive, so the job can read them on any thread without touching the dimension maps.
+// build it on the thread that owns the dimension.
+struct chunk_neighborhood {
+    // chunk coords of the first chunk.
+    pos2i origin = pos2i(0, 0);
+    // extent in chunks.
+    int width = 0;
+    int height = 0;
+    std::vector<std::shared_ptr<chunk>> chunks;
+
+    // x and y are block coords. nullptr if out of the extent or not loaded.
+    chunk* find_chunk(int x, int y) const;
+    block_behavior* find_block(int x, int y) const;
+    block_behavior* find_back_block(int x, int y) const;
+    liquid_stack find_liquid_stack(int x, int y) const;
+    // check if the block area #area is inside the extent.
+    bool covers(const quad& area) const;
+
+    // collect the chunks from #from to #to, both in chunk coords and inclusive.
+    static chunk_neighborhood make(dimension* dim, const pos2i& from, const pos2i& to);
+    // the chunk at #cpos and #radius chunks around it.
+    static chunk_neighborhood around(dimension* dim, const pos2i& cpos, int radius = 1);
+    // the chunks under the block area #area, inflated by #margin blocks.
+    static chunk_neighborhood covering(dimension* dim, const quad& area, double margin = 1);
+};
+
+}  // namespace arc
@@ -1,8 +1,18 @@
 #include "world/dim.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+
+#include "core/time.h"
 #include "ctt.h"
 #include "entity.h"
+#include "render/chunk_model.h"
 #include "render/light.h"
+#include "render/mesh_scheduler.h"
+#include "render/region_model.h"
 #include "world/block.h"
 #include "world/liquid.h"
 
@@ -11,15 +21,134 @@ namespace arc {
 void dimension::init() {
     light_executor = std::make_unique<light_engine>();
     light_executor->init(this);
+    mesh_executor = std::make_unique<mesh_scheduler>();
+    mesh_executor->init(this);
+    region_executor = std::make_unique<region_renderer>();
+    region_executor->init(this);
 }
 
 void dimension::tick() {
+    tick_entities();
+    particles.tick(this, static_cast<float>(clock::now().delta));
     for (auto& kv : chunk_map) {
         kv.second->tick();
     }
     ticks++;
 }
 
+// the entities of one physics stage, claimed in batches by the tick thread and the pool workers.
+struct physics_job_ {
+    dimension* dim;
+    std::vector<entity_handle> list;
+    double dt = 0;
+    int batches = 0;
+    std::atomic<int> next{0};
+    std::atomic<int> done{0};
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::exception_ptr error;
+
+    void run() {
+        int b;
+        while ((b = next.fetch_add(1)) < batches) {
+            size_t lo = static_cast<size_t>(b) * ARC_PHYSICS_BATCH;
+            size_t hi = std::min(lo + ARC_PHYSICS_BATCH, list.size());
+            try {
+                for (size_t i = lo; i < hi; i++) {
+                    entity* e = dim->arena.get(list[i]);
+                    e->integrate(e->tier == sim_tier::low ? dt * ARC_SIM_LOW_INTERVAL : dt);
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (!error) error = std::current_exception();
+            }
+            if (done.fetch_add(1) + 1 == batches) {
+                std::lock_guard<std::mutex> lock(mtx);
+                cv.notify_all();
+            }
+        }
+    }
+};
+
+void dimension::tick_entities() {
+    // shared with the workers, a late one may still hold it after this returns.
+    auto job = std::make_shared<physics_job_>();
+    job->dim = this;
+    job->dt = clock::now().delta;
+    // entities out of the loaded chunks stay frozen, sleeping ones only get their tick callback.
+    std::vector<entity_handle> all;
+    arena.each([&](entity* e) {
+        if (!e->parent) return;
+        all.push_back(e->handle);
+        e->tier = tier_of_(e);
+        if (e->asleep || e->tier == sim_tier::frozen) return;
+        // staggered, so a crowd in the low tier does not land on the same tick.
+        if (e->tier == sim_tier::low && (ticks + e->handle.index) % ARC_SIM_LOW_INTERVAL != 0) return;
+        job->list.push_back(e->handle);
+    });
+    job->batches = static_cast<int>((job->list.size() + ARC_PHYSICS_BATCH - 1) / ARC_PHYSICS_BATCH);
+
+    // physics stage.
+    int helpers = std::min(ARC_PHYSICS_WORKERS, job->batches - 1);
+    for (int i = 0; i < helpers; i++) thread_pool::execute([job]() { job->run(); });
+    job->run();
+    {
+        std::unique_lock<std::mutex> lock(job->mtx);
+        job->cv.wait(lock, [&]() { return job->done.load() == job->batches; });
+    }
+    if (job->error) std::rethrow_exception(job->error);
+
+    // commit phase, in slot order so a tick plays out the same way on every run.
+    // a callback may remove entities, so each one is resolved again.
+    for (entity_handle h : all) {
+        entity* e = arena.get(h);
+        if (e == nullptr) continue;
+
+        for (size_t i = 0; e != nullptr && i < e->collided_liquids_.size(); i++) {
+            e->collided_liquids_[i]->entity_collide(obs<entity>::unsafe_make(e));
+            e = arena.get(h);
+        }
+        if (e == nullptr) continue;
+        e->collided_liquids_.clear();
+        if (e->tick) e->tick(e);
+        if ((e = arena.get(h)) == nullptr) continue;
+        grid.update(e);
+
+        if (e->parent == nullptr) continue;
+        const pos2i& oldpos = e->parent->pos;
+        const pos2i& newpos = e->pos.findc();
+        if (oldpos != newpos) {
+            chunk* newc = find_chunk(newpos);
+            if (newc != nullptr) e->parent->move_entity(e, newc);
+        }
+
+        if (e->is_dead) e->parent->remove_entity(e, true);
+    }
+}
+
+sim_tier dimension::tier_of_(entity* e) {
+    if (players.empty()) return sim_tier::full;
+
+    double near = -1;
+    for (entity_handle h : players) {
+        entity* p = arena.get(h);
+        if (p == nullptr) continue;
+        double d = pos2d::dist_powered(p->pos, e->pos);
+        if (near < 0 || d < near) near = d;
+    }
+    if (near < 0 || near < ARC_SIM_FULL_RANGE * ARC_SIM_FULL_RANGE) return sim_tier::full;
+    if (near < ARC_SIM_LOW_RANGE * ARC_SIM_LOW_RANGE) return sim_tier::low;
+    return sim_tier::frozen;
+}
+
+void dimension::wake_near(const pos2i& pos) {
+    // the cell and a block around it, a resting entity touches the cells it stands on.
+    quad area = quad::corner(pos.x - 1, pos.y - 1, 3, 3);
+    grid.query(area, [&](entity* e) {
+        if (e->asleep && quad::intersect(e->box, area)) e->wake();
+    });
+}
+
 obs<chunk> dimension::find_chunk(const pos2i& pos, find_chunk_flag flag) {
     auto it = chunk_map.find(pos);
     if (it != chunk_map.end()) {
@@ -55,8 +184,13 @@ std::shared_ptr<chunk> dimension::consume_chunk_cache(const pos2i& pos) {
 }
 
 void dimension::set_chunk(const pos2i& pos, std::shared_ptr<chunk> chunk_) {
-    std::lock_guard<std::mutex> lock(chunkop_mutex_);
-    chunk_map[pos] = chunk_;
+    {
+        std::lock_guard<std::mutex> lock(chunkop_mutex_);
+        chunk_map[pos] = chunk_;
+    }
+    // marks made while it was only cached were dropped by the scheduler, queue them now it is active.
+    if (chunk_ && chunk_->model && chunk_->model->dirty_layers != 0 && mesh_executor)
+        mesh_executor->mark(chunk_.get(), 0);
 }
 
 void dimension::set_chunk_cache(const pos2i& pos, std::shared_ptr<chunk> chunk_) {
@@ -115,22 +249,33 @@ obs<codec_map> dimension::ensure_place_cdmap(const pos2i& pos) {
 }
 
 void dimension::spawn_entity(std::shared_ptr<entity> e) {
-    e->dim = this;
-    obs<chunk> chunk_ = find_chunk(e->pos.findc());
-    e->parent = chunk_;
-    if (chunk_) chunk_->spawn_entity(e);
-    entities[e->uuid] = e;
+    entity* ent = e.get();
+    ent->dim = this;
+    entities[ent->uuid] = arena.add(std::move(e));
+    obs<chunk> chunk_ = find_chunk(ent->pos.findc());
+    ent->parent = chunk_;
+    if (chunk_) chunk_->spawn_entity(ent);
+    grid.insert(ent);
 }
 
-obs<entity> dimension::find_entity(const uuid& id) { return entities[id]; }
+obs<entity> dimension::find_entity(const uuid& id) {
+    auto it = entities.find(id);
+    return it == entities.end() ? nullptr : arena.share(it->second);
+}
 
 void dimension::remove_entity(const uuid& id) {
     auto it = entities.find(id);
     if (it == entities.end()) return;
 
-    obs<chunk> chunk_ = it->second->parent;
-    if (chunk_) chunk_->remove_entity(it->second, false);
+    entity_handle h = it->second;
     entities.erase(it);
+    entity* e = arena.get(h);
+    if (e == nullptr) return;
+
+    obs<chunk> chunk_ = e->parent;
+    if (chunk_) chunk_->remove_entity(e, false);
+    grid.remove(e);
+    arena.release(h);
 }
 
 }  // namespace arc
\ No newline at end of file
@@ -6,13 +6,29 @@
 
 #include "block.h"
 #include "core/ecs.h"
+#include "core/thrp.h"
 #include "core/uuid.h"
 #include "render/light.h"
+#include "render/mesh_scheduler.h"
+#include "render/region_model.h"
+#include "world/arena.h"
 #include "world/entity.h"
 #include "world/liquid.h"
 #include "world/chunk.h"
+#include "world/grid.h"
+#include "world/particle.h"
 #include "world/pos.h"
 
+// entities integrated by one claim of a physics worker.
+#define ARC_PHYSICS_BATCH 64
+// pool workers joining the tick thread in the physics stage.
+#define ARC_PHYSICS_WORKERS ARC_THREAD_POOL_KERNELS
+// simulation tiers by the distance (blocks) to the nearest player, see sim_tier.
+#define ARC_SIM_FULL_RANGE 96
+#define ARC_SIM_LOW_RANGE 192
+// the low tier is integrated once in this many ticks, with the time of all of them.
+#define ARC_SIM_LOW_INTERVAL 4
+
 namespace arc {
 
 struct dimension;
@@ -89,13 +105,26 @@ struct dimension : componentable_dimension_ {
     std::unordered_map<pos2i, std::shared_ptr<chunk>> chunk_map;
     std::unordered_map<pos2i, std::shared_ptr<chunk>> chunk_cache_map;
     std::unique_ptr<light_engine> light_executor = nullptr;
-    std::unordered_map<uuid, std::shared_ptr<entity>> entities;
+    std::unique_ptr<mesh_scheduler> mesh_executor = nullptr;
+    std::unique_ptr<region_renderer> region_executor = nullptr;
+    entity_arena arena;
+    // uuid to arena handle, for the lookups coming from packets and saves.
+    std::unordered_map<uuid, entity_handle> entities;
+    // entities the simulation tiers are measured from. with none, every entity runs the full tier.
+    std::vector<entity_handle> players;
+    particle_system particles;
+    entity_grid grid;
     bool server;
     bool remote;
     uint32_t ticks;
 
     void init();
     void tick();
+    // integrate all entities in parallel, then commit moves, deaths and tick callbacks in slot order.
+    void tick_entities();
+    sim_tier tier_of_(entity* e);
+    // wake the sleeping entities touching the cell at #pos, after it changed.
+    void wake_near(const pos2i& pos);
 
     obs<chunk> find_chunk(const pos2i& pos, find_chunk_flag flag = find_chunk_flag::no);
     obs<chunk> find_chunk_by_block(const pos2i& pos, find_chunk_flag flag = find_chunk_flag::no);
@@ -113,8 +142,10 @@ struct dimension : componentable_dimension_ {
     void set_liquid_stack(const liquid_stack& s, const pos2i& pos);
     obs<codec_map> find_place_cdmap(const pos2i& pos);
     obs<codec_map> ensure_place_cdmap(const pos2i& pos);
+    // #e may come from arena#make, then it lives in the pooled memory of this dimension.
     void spawn_entity(std::shared_ptr<entity> e);
     obs<entity> find_entity(const uuid& id);
+    entity* find_entity(entity_handle h) const { return arena.get(h); }
     void remove_entity(const uuid& id);
 };
 
@@ -1,5 +1,6 @@
 #include "world/dimh.h"
 
+#include "world/chunk.h"
 #include "world/entity.h"
 #include "world/pos.h"
 
@@ -25,8 +26,32 @@ std::vector<pos2i>& get_maybe_intersected_poses(const quad& box, double dx, doub
     return result_;
 }
 
-std::vector<obs<entity>>& get_intersected_entities(dimension* dim, const quad& box) {
-    return get_intersected_entities(dim, box, [](const obs<entity>) { return true; });
+std::vector<entity*>& get_intersected_entities(dimension* dim, const quad& box) {
+    return get_intersected_entities(dim, box, [](entity*) { return true; });
+}
+
+std::vector<entity*>& get_intersected_entities(const chunk_neighborhood& nb, const quad& box) {
+    static thread_local std::vector<entity*> result_;
+    result_.clear();
+
+    int i1 = std::floor((box.x - ARC_FIND_ENTITY_INFLATION) / 16.0);
+    int i2 = std::floor((box.prom_x() + ARC_FIND_ENTITY_INFLATION) / 16.0);
+    int j1 = std::floor((box.y - ARC_FIND_ENTITY_INFLATION) / 16.0);
+    int j2 = std::floor((box.prom_y() + ARC_FIND_ENTITY_INFLATION) / 16.0);
+
+    for (int i = i1; i <= i2; i++) {
+        for (int j = j1; j <= j2; j++) {
+            chunk* chunk = nb.find_chunk(i * ARC_CHUNK_SIZE, j * ARC_CHUNK_SIZE);
+            if (chunk == nullptr) continue;
+
+            for (entity* e : chunk->entities) {
+                if (e->is_dead) continue;
+                // an entity is in the list of one chunk only, no need to de-duplicate.
+                if (quad::intersect(e->box, box)) result_.push_back(e);
+            }
+        }
+    }
+    return result_;
 }
 
 }  // namespace dim_util
@@ -8,15 +8,20 @@
 #include "core/math.h"
 #include "core/obsptr.h"
 #include "core/time.h"
+#include "world/chunk.h"
 #include "world/dim.h"
 #include "world/dimh.h"
 #include "world/liquid.h"
 
 namespace arc {
 
-void physic_obj::impulse(const vec2& imp) { velocity = velocity + imp / mass; }
+void physic_obj::impulse(const vec2& imp) {
+    if (asleep) wake();
+    velocity = velocity + imp / mass;
+}
 
 void physic_obj::impulse_limited(const vec2& imp) {
+    if (asleep) wake();
     double dvx = imp.x / mass;
     double dvy = imp.y / mass;
     double end_x, end_y;
@@ -35,6 +40,7 @@ void physic_obj::impulse_limited(const vec2& imp) {
 }
 
 void physic_obj::move(const vec2& acc, const vec2& lim, uint8_t ig) {
+    if (asleep && (acc.x != 0 || acc.y != 0)) wake();
     if (acc.x > 0 && velocity.x < lim.x)
         velocity.x = std::clamp(acc.x + velocity.x, -32767.0, lim.x);
     else if (acc.x < 0 && velocity.x > -lim.x)
@@ -49,12 +55,14 @@ void physic_obj::move(const vec2& acc, const vec2& lim, uint8_t ig) {
 }
 
 void physic_obj::locate(const pos2d& pos_) {
+    if (asleep) wake();
     prev_pos = pos;
     box.locate_center(pos_.x, pos_.y);
     pos = pos_;
 }
 
 void physic_obj::locate_primary(const pos2d& pos_) {
+    if (asleep) wake();
     box.locate_center(pos_.x, pos_.y);
     pos = prev_pos = pos_;
 }
@@ -65,8 +73,74 @@ quad physic_obj::lerped_box_() {
     return quad::center(lx, ly, box.width, box.height);
 }
 
-void entity::motion() {
-    double dt = clock::now().delta;
+// reads cell shapes from the chunk masks. the last chunk is kept, a sweep rarely leaves it.
+struct solid_probe_ {
+    dimension* dim;
+    entity* e;
+    chunk* last = nullptr;
+    pos2i last_pos = pos2i(INT32_MAX, INT32_MAX);
+
+    // the shape blocking at (x, y), nullptr when nothing does.
+    cube_outline* at(int x, int y) {
+        pos2i cpos = pos2i(x, y).findc();
+        if (cpos != last_pos) {
+            last = dim->find_chunk(cpos, find_chunk_flag::cache);
+            last_pos = cpos;
+        }
+        if (last == nullptr) return nullptr;
+        if (last->is_solid_(x, y)) return &cube_outline::solid;
+        // only these cells pay for the block lookup.
+        if (!last->is_shaped_(x, y)) return nullptr;
+        pos2i bpos = pos2i(x, y);
+        return last->find_block(bpos)->voxel_shape(dim, bpos, obs<entity>::unsafe_make(e));
+    }
+};
+
+// clip #dx against the cells in front of #box, column by column from the leading edge.
+// stops once the clipped move cannot reach the next column. blocking cells go to #hits if given.
+static double sweep_x_(solid_probe_& probe, const quad& box, double dx, std::vector<pos2i>* hits) {
+    int y0 = static_cast<int>(std::floor(box.y));
+    int y1 = static_cast<int>(std::ceil(box.prom_y())) - 1;
+    int step = dx > 0 ? 1 : -1;
+    int x = dx > 0 ? static_cast<int>(std::floor(box.prom_x())) : static_cast<int>(std::ceil(box.x)) - 1;
+
+    while (dx != 0) {
+        // the clipped move ends before this column.
+        if (dx > 0 ? box.prom_x() + dx <= x : box.x + dx >= x + 1) break;
+        for (int y = y0; y <= y1; y++) {
+            cube_outline* cubic = probe.at(x, y);
+            if (cubic == nullptr) continue;
+            double dx0 = dx;
+            dx = cubic->clip_x(x, y, dx, box);
+            if (hits && std::abs(dx - dx0) > ARC_MTOL) hits->push_back({x, y});
+        }
+        x += step;
+    }
+    return dx;
+}
+
+// #sweep_x_ along y, row by row.
+static double sweep_y_(solid_probe_& probe, const quad& box, double dy, std::vector<pos2i>* hits) {
+    int x0 = static_cast<int>(std::floor(box.x));
+    int x1 = static_cast<int>(std::ceil(box.prom_x())) - 1;
+    int step = dy > 0 ? 1 : -1;
+    int y = dy > 0 ? static_cast<int>(std::floor(box.prom_y())) : static_cast<int>(std::ceil(box.y)) - 1;
+
+    while (dy != 0) {
+        if (dy > 0 ? box.prom_y() + dy <= y : box.y + dy >= y + 1) break;
+        for (int x = x0; x <= x1; x++) {
+            cube_outline* cubic = probe.at(x, y);
+            if (cubic == nullptr) continue;
+            double dy0 = dy;
+            dy = cubic->clip_y(x, y, dy, box);
+            if (hits && std::abs(dy - dy0) > ARC_MTOL) hits->push_back({x, y});
+        }
+        y += step;
+    }
+    return dy;
+}
+
+void entity::motion(double dt) {
     quad origin = box;
     quad destination = box;
 
@@ -82,27 +156,10 @@ void entity::motion() {
     if (std::abs(dy) < ARC_MTOL) dy = 0;
 
     // move session
-
-    // itr block macro
-#define ARC_GET_VCUBE_                                                         \
-    block_behavior* block = dim->find_block(bpos);                             \
-    cube_outline* cubic = nullptr;                                             \
-    if (block->voxel_shape)                                                    \
-        cubic = block->voxel_shape(dim, bpos, obs<entity>::unsafe_make(this)); \
-    else                                                                       \
-        cubic = block->shape.solid ? &cube_outline::solid : &cube_outline::vaccum;
-    // end
-
+    solid_probe_ probe{dim, this};
     collision.clear();
 
-    if (dx != 0) {
-        for (auto& bpos : dim_util::get_maybe_intersected_poses(destination, dx, 0)) {
-            ARC_GET_VCUBE_
-            double dx0 = dx;
-            dx = cubic->clip_x(bpos.x, bpos.y, dx, destination);
-            if (std::abs(dx - dx0) > ARC_MTOL) collision.push_back(bpos);
-        }
-    }
+    if (dx != 0) dx = sweep_x_(probe, destination, dx, &collision);
 
     // step check.
     // It's rational - we only check it when we find something blocking entity's pace forwards.
@@ -110,13 +167,8 @@ void entity::motion() {
         // step up
         if (((phy_status & phybit::touch_d) || (phy_status & phybit::swim)) && std::abs(dx - dx0) > ARC_MTOL) {
             quad step_to = origin;
-            double dx1 = dx0;
             step_to.translate(0, -ARC_STEP_H);
-
-            for (auto& bpos : dim_util::get_maybe_intersected_poses(step_to, dx1, 0)) {
-                ARC_GET_VCUBE_
-                dx1 = cubic->clip_x(bpos.x, bpos.y, dx1, step_to);
-            }
+            double dx1 = sweep_x_(probe, step_to, dx0, nullptr);
 
             if (std::abs(dx1 - dx) > ARC_MTOL && std::abs(dx1) > ARC_MTOL) {
                 destination.translate(dx1, -ARC_STEP_H);
@@ -130,13 +182,8 @@ void entity::motion() {
         // step down
         if (!stepped && (prev_phy_status & phybit::touch_d) && !(phy_status & phybit::touch_d)) {
             quad step_to = origin;
-            double dx1 = dx0;
             step_to.translate(0, ARC_STEP_H);
-
-            for (auto& bpos : dim_util::get_maybe_intersected_poses(step_to, dx1, 0)) {
-                ARC_GET_VCUBE_
-                dx1 = cubic->clip_x(bpos.x, bpos.y, dx1, step_to);
-            }
+            double dx1 = sweep_x_(probe, step_to, dx0, nullptr);
 
             if (std::abs(dx1 - dx) > ARC_MTOL && std::abs(dx1) > ARC_MTOL) {
                 destination.translate(dx1, 0);
@@ -150,14 +197,7 @@ void entity::motion() {
 
     if (!stepped) destination.translate(dx, 0);
 
-    if (dy != 0) {
-        for (auto& bpos : dim_util::get_maybe_intersected_poses(destination, 0, dy)) {
-            ARC_GET_VCUBE_
-            double dy0 = dy;
-            dy = cubic->clip_y(bpos.x, bpos.y, dy, destination);
-            if (std::abs(dy - dy0) > ARC_MTOL) collision.push_back(bpos);
-        }
-    }
+    if (dy != 0) dy = sweep_y_(probe, destination, dy, &collision);
 
     destination.translate(0, dy);
 
@@ -200,8 +240,24 @@ void entity::motion() {
     if (r && velocity.x > 0) velocity.x *= -rebound;
 }
 
-void entity::force() {
-    double dt = clock::now().delta;
+void entity::integrate(double dt) {
+    force(dt);
+    motion(dt);
+
+    // on the ground the vertical speed is only the rebound of this step's gravity, it never gets small for a bouncy
+    // entity, so only the horizontal speed is measured.
+    bool resting = (phy_status & phybit::touch_d) && !(phy_status & phybit::swim) &&
+                   velocity.x * velocity.x < ARC_SLEEP_SPEED2;
+    rest_ticks_ = resting ? std::min(rest_ticks_ + 1, ARC_SLEEP_TICKS) : 0;
+    if (rest_ticks_ == ARC_SLEEP_TICKS) {
+        asleep = true;
+        velocity = vec2(0, 0);
+        // drawn still, not lerped from the last step.
+        prev_pos = pos;
+    }
+}
+
+void entity::force(double dt) {
     // ------ force set session ------ //
 
     // gravity session
@@ -209,7 +265,8 @@ void entity::force() {
 
     // liquid session
 
-    if (!low_phy_sim) {
+    collided_liquids_.clear();
+    if (!low_phy_sim && tier == sim_tier::full) {
         // liquid collision calculation
         wetted_volume.clear();
         for (auto& pos : dim_util::get_maybe_intersected_poses(box, 0, 0)) {
@@ -227,7 +284,7 @@ void entity::force() {
             for (auto& kv : wetted_volume) {
                 liquid_behavior* liquid = kv.first;
                 double vol = kv.second;
-                liquid->entity_collide(obs<entity>::unsafe_make(this));
+                collided_liquids_.push_back(liquid);
                 // floating force
                 impulse(vec2(0, -ARC_GRAVITY_A * ARC_E_FUL * liquid->density(dim) * vol * dt));
                 // dragging force
@@ -243,7 +300,7 @@ void entity::force() {
 
     // air session
     double spd2 = velocity.length_powered();
-    if (spd2 > ARC_MTOL && !low_phy_sim && !(ignore_lf_ & physic_ignore::air_f)) {
+    if (spd2 > ARC_MTOL && !low_phy_sim && tier == sim_tier::full && !(ignore_lf_ & physic_ignore::air_f)) {
         impulse_limited(-velocity.normal() * ARC_AIR_RHO * ARC_E_C_D * unit::to_meter_vol(box) * spd2 * 0.5 * dt);
     }
 
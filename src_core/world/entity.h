@@ -19,6 +19,10 @@
 #define ARC_E_FUL 0.5
 // unit: block
 #define ARC_STEP_H 1.15
+// an entity resting this many ticks in a row falls asleep.
+#define ARC_SLEEP_TICKS 30
+// squared horizontal speed (m/s) under which an entity on the ground counts as resting.
+#define ARC_SLEEP_SPEED2 1e-4
 
 namespace arc {
 
@@ -37,6 +41,8 @@ struct dimension;
 struct chunk;
 
 enum class entity_cat : uint8_t { none, creature, projectile, placement, particle };
+// full: every tick. low: every few ticks without liquid and air. frozen: no physics.
+enum class sim_tier : uint8_t { full, low, frozen };
 
 namespace physic_ignore {
 
@@ -79,7 +85,10 @@ struct physic_obj {
     bool net_dirty = true;
     bool server_auth = true;
     bool low_phy_sim = false;
+    // a sleeping object is skipped by physics until it is woken, see #wake.
+    bool asleep = false;
     uint8_t ignore_lf_ = physic_ignore::none;
+    uint8_t rest_ticks_ = 0;
 
     void impulse(const vec2& imp);
     void impulse_limited(const vec2& imp);
@@ -87,20 +96,49 @@ struct physic_obj {
     void locate(const pos2d& pos_);
     void locate_primary(const pos2d& pos_);
     quad lerped_box_();
+    // impulses, moves and relocations wake the object, so do block and liquid changes next to it.
+    void wake() {
+        asleep = false;
+        rest_ticks_ = 0;
+    }
+};
+
+// a slot index in the entity arena of a dimension, plus the generation of the slot when it was handed out.
+struct entity_handle {
+    uint32_t index = UINT32_MAX;
+    uint32_t gen = 0;
+
+    bool operator==(const entity_handle& o) const { return index == o.index && gen == o.gen; }
+    bool operator!=(const entity_handle& o) const { return !(*this == o); }
+    explicit operator bool() const { return index != UINT32_MAX; }
 };
 
 struct entity : physic_obj {
+    // the network and persistence identity, the dimension resolves it to #handle.
     uuid uuid = uuid::make();
+    entity_handle handle;
     obs<chunk> parent = nullptr;
     dimension* dim = nullptr;
-    uint32_t wt_anc_ = 0;
+    // slot in the entity grid of the dimension, -1 when not listed.
+    int grid_slot_ = -1;
+    // index in the entity list of the parent chunk, -1 when not listed.
+    int chunk_slot_ = -1;
     uint32_t ticks = 0;
     bool is_dead = false;
     float death_timer = 0.0;
     entity_cat cat;
-
-    void motion();
-    void force();
+    // set by the dimension each tick from the distance to the nearest player.
+    sim_tier tier = sim_tier::full;
+
+    // liquids touched in the last #force, their entity_collide runs in the commit phase.
+    std::vector<liquid_behavior*> collided_liquids_;
+
+    void motion(double dt);
+    void force(double dt);
+    // the physics of #dt seconds, #force then #motion. it reads the world and writes only this entity,
+    // so entities are integrated in parallel. voxel_shape and the block properties it reads must not write.
+    // an entity resting on the ground for ARC_SLEEP_TICKS integrations falls asleep.
+    void integrate(double dt);
     std::function<void(entity* self)> tick;
     std::function<float(entity* self, int pipe)> cast_light;
 };
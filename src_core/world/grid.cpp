@@ -0,0 +1,76 @@
+#include "world/grid.h"
+
+#include "world/entity.h"
+
+namespace arc {
+
+void entity_grid::link_(int idx) {
+    slot& s = slots[idx];
+    for (int cx = s.cx0; cx <= s.cx1; cx++)
+        for (int cy = s.cy0; cy <= s.cy1; cy++) cells[{cx, cy}].push_back(idx);
+}
+
+void entity_grid::unlink_(int idx) {
+    slot& s = slots[idx];
+    for (int cx = s.cx0; cx <= s.cx1; cx++) {
+        for (int cy = s.cy0; cy <= s.cy1; cy++) {
+            auto it = cells.find({cx, cy});
+            if (it == cells.end()) continue;
+            std::vector<int>& list = it->second;
+            auto at = std::find(list.begin(), list.end(), idx);
+            if (at != list.end()) {
+                *at = list.back();
+                list.pop_back();
+            }
+            if (list.empty()) cells.erase(it);
+        }
+    }
+}
+
+void entity_grid::insert(entity* e) {
+    if (e->grid_slot_ >= 0) return;
+
+    int idx;
+    if (!free_slots.empty()) {
+        idx = free_slots.back();
+        free_slots.pop_back();
+    } else {
+        idx = static_cast<int>(slots.size());
+        slots.emplace_back();
+    }
+
+    slot& s = slots[idx];
+    s.ref = e;
+    s.used = true;
+    s.cx0 = cell_of(e->box.x), s.cx1 = cell_of(e->box.prom_x());
+    s.cy0 = cell_of(e->box.y), s.cy1 = cell_of(e->box.prom_y());
+    e->grid_slot_ = idx;
+    link_(idx);
+}
+
+void entity_grid::update(entity* e) {
+    int idx = e->grid_slot_;
+    if (idx < 0) return;
+
+    slot& s = slots[idx];
+    int cx0 = cell_of(e->box.x), cx1 = cell_of(e->box.prom_x());
+    int cy0 = cell_of(e->box.y), cy1 = cell_of(e->box.prom_y());
+    // most moves stay inside the same cells.
+    if (cx0 == s.cx0 && cx1 == s.cx1 && cy0 == s.cy0 && cy1 == s.cy1) return;
+
+    unlink_(idx);
+    s.cx0 = cx0, s.cx1 = cx1, s.cy0 = cy0, s.cy1 = cy1;
+    link_(idx);
+}
+
+void entity_grid::remove(entity* e) {
+    int idx = e->grid_slot_;
+    if (idx < 0) return;
+
+    unlink_(idx);
+    slots[idx] = slot();
+    free_slots.push_back(idx);
+    e->grid_slot_ = -1;
+}
+
+}  // namespace arc
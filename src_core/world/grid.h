@@ -0,0 +1,71 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "core/math.h"
+#include "world/pos.h"
+
+// a broadphase cell is 1 << ARC_GRID_CELL_SHIFT blocks wide.
+#define ARC_GRID_CELL_SHIFT 2
+
+namespace arc {
+
+struct entity;
+
+// a uniform grid over the entity boxes of a dimension, for box queries.
+// an entity is listed by its slot index in every cell its box covers, and only moves between cells
+// when the covered range changes.
+struct entity_grid {
+    struct slot {
+        entity* ref = nullptr;
+        // the covered cells, inclusive.
+        int cx0, cy0, cx1, cy1;
+        bool used = false;
+    };
+
+    std::vector<slot> slots;
+    std::vector<int> free_slots;
+    std::unordered_map<pos2i, std::vector<int>> cells;
+
+    void insert(entity* e);
+    // call after the box of the entity changed.
+    void update(entity* e);
+    void remove(entity* e);
+
+    static int cell_of(double v) { return static_cast<int>(std::floor(v)) >> ARC_GRID_CELL_SHIFT; }
+
+    // visit every entity listed in the cells under #box once. the boxes are as of the last update, test them again.
+    template <typename F>
+    void query(const quad& box, F&& f) {
+        // stamps are per thread, so concurrent queries do not share them.
+        static thread_local std::vector<uint32_t> stamps_;
+        static thread_local uint32_t epoch_ = 0;
+        if (++epoch_ == 0) {
+            std::fill(stamps_.begin(), stamps_.end(), 0);
+            epoch_ = 1;
+        }
+        if (stamps_.size() < slots.size()) stamps_.resize(slots.size(), 0);
+
+        int cx0 = cell_of(box.x), cx1 = cell_of(box.prom_x());
+        int cy0 = cell_of(box.y), cy1 = cell_of(box.prom_y());
+        for (int cx = cx0; cx <= cx1; cx++) {
+            for (int cy = cy0; cy <= cy1; cy++) {
+                auto it = cells.find({cx, cy});
+                if (it == cells.end()) continue;
+                for (int idx : it->second) {
+                    if (stamps_[idx] == epoch_) continue;
+                    stamps_[idx] = epoch_;
+                    f(slots[idx].ref);
+                }
+            }
+        }
+    }
+
+    void link_(int idx);
+    void unlink_(int idx);
+};
+
+}  // namespace arc
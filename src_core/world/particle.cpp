@@ -0,0 +1,197 @@
+#include "world/particle.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "core/log.h"
+#include "gfx/brush.h"
+#include "gfx/image.h"
+#include "world/chunk.h"
+#include "world/dim.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define ARC_PARTICLE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace arc {
+
+int particle_system::frame_of(std::shared_ptr<texture> tex) {
+    for (size_t i = 0; i < frames.size(); i++)
+        if (frames[i] == tex) return static_cast<int>(i);
+    if (frames.size() > UINT16_MAX) print_throw(log_level::fatal, "too many particle frames.");
+
+    int page = 0;
+    for (; page < static_cast<int>(pages_.size()); page++)
+        if (pages_[page]->texture_id_ == tex->texture_id_) break;
+    if (page == static_cast<int>(pages_.size())) pages_.push_back(tex);
+
+    frames.push_back(tex);
+    frame_src_.push_back(quad(tex->u, tex->v, tex->width, tex->height));
+    frame_page_.push_back(page);
+    return static_cast<int>(frames.size()) - 1;
+}
+
+bool particle_system::emit(const pos2d& pos, const vec2& vel, float life_, float size_, const color& col, int frame_,
+                           uint8_t flag) {
+    if (x.size() >= ARC_PARTICLE_LIMIT) return false;
+    if (frame_ < 0 || frame_ >= static_cast<int>(frames.size())) return false;
+
+    uint8_t r, g, b, a;
+    color c = col;
+    c.get_bytes(&r, &g, &b, &a);
+
+    x.push_back(static_cast<float>(pos.x));
+    y.push_back(static_cast<float>(pos.y));
+    vx.push_back(static_cast<float>(vel.x));
+    vy.push_back(static_cast<float>(vel.y));
+    life.push_back(life_);
+    size.push_back(size_);
+    rgba.push_back(r | g << 8 | b << 16 | static_cast<uint32_t>(a) << 24);
+    frame.push_back(static_cast<uint16_t>(frame_));
+    flags.push_back(flag);
+    return true;
+}
+
+void particle_system::integrate_(float dt) {
+    size_t n = x.size();
+    float drag = std::pow(ARC_PARTICLE_DRAG, dt);
+    float gdt = gravity * dt;
+    size_t i = 0;
+
+#ifdef ARC_PARTICLE_SSE2
+    __m128 vdt = _mm_set1_ps(dt);
+    __m128 vdrag = _mm_set1_ps(drag);
+    __m128 vgdt = _mm_set1_ps(gdt);
+    for (; i + 4 <= n; i += 4) {
+        __m128 nvx = _mm_mul_ps(_mm_loadu_ps(&vx[i]), vdrag);
+        __m128 nvy = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&vy[i]), vgdt), vdrag);
+        _mm_storeu_ps(&vx[i], nvx);
+        _mm_storeu_ps(&vy[i], nvy);
+        _mm_storeu_ps(&x[i], _mm_add_ps(_mm_loadu_ps(&x[i]), _mm_mul_ps(nvx, vdt)));
+        _mm_storeu_ps(&y[i], _mm_add_ps(_mm_loadu_ps(&y[i]), _mm_mul_ps(nvy, vdt)));
+        _mm_storeu_ps(&life[i], _mm_sub_ps(_mm_loadu_ps(&life[i]), vdt));
+    }
+#endif
+
+    for (; i < n; i++) {
+        vx[i] = vx[i] * drag;
+        vy[i] = (vy[i] + gdt) * drag;
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+        life[i] -= dt;
+    }
+}
+
+void particle_system::collide_(dimension* dim, float dt) {
+    // the last chunk is kept, particles of one burst stay close.
+    chunk* last = nullptr;
+    pos2i last_pos = pos2i(INT32_MAX, INT32_MAX);
+    auto solid = [&](float fx, float fy) {
+        int bx = static_cast<int>(std::floor(fx));
+        int by = static_cast<int>(std::floor(fy));
+        pos2i cpos = pos2i(bx, by).findc();
+        if (cpos != last_pos) {
+            last = dim->find_chunk(cpos, find_chunk_flag::cache);
+            last_pos = cpos;
+        }
+        return last != nullptr && last->is_solid_(bx, by);
+    };
+
+    for (size_t i = 0; i < x.size(); i++) {
+        if (!(flags[i] & particle_flag::collide) || !solid(x[i], y[i])) continue;
+
+        // undo the move on the axis that entered the cell.
+        float ox = x[i] - vx[i] * dt;
+        float oy = y[i] - vy[i] * dt;
+        if (!solid(ox, y[i])) {
+            x[i] = ox;
+            vx[i] *= -ARC_PARTICLE_BOUNCE;
+        } else if (!solid(x[i], oy)) {
+            y[i] = oy;
+            vy[i] *= -ARC_PARTICLE_BOUNCE;
+            vx[i] *= ARC_PARTICLE_DRAG;
+        } else {
+            x[i] = ox;
+            y[i] = oy;
+            vx[i] = vy[i] = 0;
+        }
+    }
+}
+
+template <typename T>
+static void swap_out_(std::vector<T>& v, size_t i) {
+    v[i] = v.back();
+    v.pop_back();
+}
+
+void particle_system::kill_(size_t i) {
+    swap_out_(x, i);
+    swap_out_(y, i);
+    swap_out_(vx, i);
+    swap_out_(vy, i);
+    swap_out_(life, i);
+    swap_out_(size, i);
+    swap_out_(rgba, i);
+    swap_out_(frame, i);
+    swap_out_(flags, i);
+}
+
+void particle_system::tick(dimension* dim, float dt) {
+    if (x.empty()) return;
+
+    integrate_(dt);
+    collide_(dim, dt);
+    for (size_t i = 0; i < x.size();) {
+        if (life[i] <= 0)
+            kill_(i);
+        else
+            i++;
+    }
+}
+
+void particle_system::render(brush* brush, const quad& view) {
+    if (x.empty()) return;
+
+    page_runs_.resize(pages_.size());
+    for (auto& run : page_runs_) run.clear();
+
+    float vx0 = view.x, vy0 = view.y, vx1 = view.prom_x(), vy1 = view.prom_y();
+    for (size_t i = 0; i < x.size(); i++) {
+        float h = size[i] * 0.5f;
+        if (x[i] + h < vx0 || x[i] - h > vx1 || y[i] + h < vy0 || y[i] - h > vy1) continue;
+        page_runs_[frame_page_[frame[i]]].push_back(static_cast<uint32_t>(i));
+    }
+
+    for (size_t p = 0; p < page_runs_.size(); p++) {
+        const std::vector<uint32_t>& run = page_runs_[p];
+        if (run.empty()) continue;
+
+        run_dst_.resize(run.size());
+        run_src_.resize(run.size());
+        run_col_.resize(run.size());
+        for (size_t k = 0; k < run.size(); k++) {
+            uint32_t i = run[k];
+            uint32_t c = rgba[i];
+            run_dst_[k] = quad::center(x[i], y[i], size[i], size[i]);
+            run_src_[k] = frame_src_[frame[i]];
+            run_col_[k] = color::from_bytes(c & 0xFF, c >> 8 & 0xFF, c >> 16 & 0xFF, c >> 24);
+        }
+        brush->draw_texture_run(pages_[p], static_cast<int>(run.size()), run_dst_.data(), run_src_.data(),
+                                run_col_.data());
+    }
+}
+
+void particle_system::clear() {
+    x.clear();
+    y.clear();
+    vx.clear();
+    vy.clear();
+    life.clear();
+    size.clear();
+    rgba.clear();
+    frame.clear();
+    flags.clear();
+}
+
+}  // namespace arc
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "core/math.h"
+#include "gfx/color.h"
+#include "world/entity.h"
+#include "world/pos.h"
+
+// particles over this are not emitted.
+#define ARC_PARTICLE_LIMIT 65536
+// velocity kept per second, for all particles.
+#define ARC_PARTICLE_DRAG 0.6f
+// speed kept when bouncing off a solid cell.
+#define ARC_PARTICLE_BOUNCE 0.3f
+
+namespace arc {
+
+struct brush;
+struct dimension;
+struct texture;
+
+namespace particle_flag {
+
+static const uint8_t none = 0;
+// stopped by solid cells, looked up in the chunk solid masks only.
+static const uint8_t collide = 1U << 0;
+
+};  // namespace particle_flag
+
+// particles without entities: no uuid, no grid slot, no callbacks.
+// the fields are kept as structure of arrays, particle i is index i of each, and a dead particle is replaced by the
+// last one. positions and speeds are in blocks and blocks per second.
+struct particle_system {
+    std::vector<float> x, y;
+    std::vector<float> vx, vy;
+    // seconds left.
+    std::vector<float> life;
+    std::vector<float> size;
+    // rgba8.
+    std::vector<uint32_t> rgba;
+    // index into #frames.
+    std::vector<uint16_t> frame;
+    std::vector<uint8_t> flags;
+
+    // textures particles are drawn with, see #frame_of.
+    std::vector<std::shared_ptr<texture>> frames;
+    // per frame, its texels on the page and the index of the page in #pages_.
+    std::vector<quad> frame_src_;
+    std::vector<int> frame_page_;
+    // one texture of each page, the runs are drawn with it.
+    std::vector<std::shared_ptr<texture>> pages_;
+    // blocks per second squared.
+    float gravity = static_cast<float>(unit::to_block(ARC_GRAVITY_A));
+
+    // render scratch, kept to not allocate each frame.
+    std::vector<std::vector<uint32_t>> page_runs_;
+    std::vector<quad> run_dst_, run_src_;
+    std::vector<color> run_col_;
+
+    size_t count() const { return x.size(); }
+    // the frame index of #tex, registered on first use.
+    int frame_of(std::shared_ptr<texture> tex);
+    // false when the limit is reached or #frame is not one from #frame_of.
+    bool emit(const pos2d& pos, const vec2& vel, float life, float size, const color& col, int frame,
+              uint8_t flag = particle_flag::none);
+    void tick(dimension* dim, float dt);
+    // draw the particles inside #view, one run for each page.
+    void render(brush* brush, const quad& view);
+    void clear();
+
+    void integrate_(float dt);
+    void collide_(dimension* dim, float dt);
+    void kill_(size_t i);
+};
+
+}  // namespace arc